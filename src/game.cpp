@@ -1,4 +1,6 @@
 #include "game.hpp"
+#include "game_analysis.hpp"
+#include "game_builtin_levels.hpp"
 
 #include <algorithm>
 #include <array>
@@ -8,24 +10,21 @@
 
 using namespace std;
 
-// static data.
-static constexpr TileType TxtMap(char c) {
-    switch (c) {
-    case ' ': return TILE_SPACE;
-    case '#': return TILE_WALL;
-    case '$': return TILE_BOX;
-    case '@': return TILE_PLAYER;
-    case '*': return TILE_BOX_ON_TARGET;
-    case '.': return TILE_TARGET;
-    case '+': return TILE_PLAYER_ON_TARGET;
-    default:
-        assert(c == '_');
-        return TILE_NULL;
-    }
-}
-
 bool Sokoban::LoadLevel(const Level& level) {
     Clear();
+    version++;
+    if (level.parsed.tiles) {
+        // into the rows already there: restarting allocates nothing.
+        const auto& p = level.parsed;
+        state.resize(p.rows);
+        for (int32_t r = 0; r < p.rows; r++)
+            state[r].assign(p.tiles + r * p.cols, p.tiles + (r + 1) * p.cols);
+        playerPos        = p.player;
+        numBoxes         = p.numBoxes;
+        numBoxesOnTarget = p.numBoxesOnTarget;
+        analysis = Analyze(level);
+        return true;
+    }
     state = vector<vector<TileType>>(level.lines.size());
     std::transform(level.lines.begin(), level.lines.end(), state.begin(), [](const string& s)->vector<TileType>{
             // one liner in C++23 but we are just using C++17...
@@ -45,29 +44,45 @@ bool Sokoban::LoadLevel(const Level& level) {
             }
         }
     }
+    analysis = Analyze(level);
     return true;
 }
 
+// The analysis only depends on the start of the level, just loaded into state:
+// a level of the pack gets it once, restarts and returns reuse it.
+shared_ptr<const LevelAnalysis> Sokoban::Analyze(const Level& level) {
+    less<const Level*> before;
+    if (analyses.size() != levels.size() || before(&level, levels.data()) || !before(&level, levels.data() + levels.size()))
+        return make_shared<const LevelAnalysis>(AnalyzeLevel(state));
+    auto& cached = analyses[&level - levels.data()];
+    if (!cached)
+        cached = make_shared<const LevelAnalysis>(AnalyzeLevel(state));
+    return cached;
+}
+
+// Checked and parsed by the compiler: a bad level here doesn't build.
+static constexpr char DEFAULT_LEVELS[] = R"(
+debug level
+######
+#@$ .#
+######
+
+Default Level
+_####__
+_# .#__
+_#  ###
+_#*@  #
+##  $ #
+#   ###
+#####__
+)";
+static constexpr auto DEFAULT_PACK = GameBuiltin::Parse<GameBuiltin::NumLevels(DEFAULT_LEVELS),
+                                                        GameBuiltin::NumCells (DEFAULT_LEVELS)>(DEFAULT_LEVELS);
+
 void Sokoban::LoadDefaultLevels() {
-    static const std::array defaultLevel0 {
-        "######",
-        "#@$ .#",
-        "######",
-    };
-    static const std::array defaultLevel1 {
-        "_####__",
-        "_# .#__",
-        "_#  ###",
-        "_#*@  #",
-        "##  $ #",
-        "#   ###",
-        "#####__",
-    };
-
-    levels   = {{"debug level"  , vector<string>(defaultLevel0.begin(), defaultLevel0.end())},
-                {"Default Level", vector<string>(defaultLevel1.begin(), defaultLevel1.end())},
-                };
+    levels   = GameBuiltin::Levels(DEFAULT_PACK);
     curLevel = 0;
+    ResetPack();
     LoadLevel(levels[curLevel]);
 }
 
@@ -94,6 +109,7 @@ void Sokoban::MoveBox(Pos p, Pos dp) {
         assert(numBoxesOnTarget >= 0);
     }
     accessCache.clear();
+    version++;
 }
 
 void Sokoban::Push(int dy, int dx) {
@@ -105,8 +121,11 @@ void Sokoban::Push(int dy, int dx) {
             return SetPlayerPos(playerPos, dy,dx);
         history.push({newPos, dp});
         MoveBox(newPos, dp);
+        CurStats().pushes++;
+        CurStats().completions += LevelCompleted();
     }
     if (IsSpace(newPos)) {
+        CurStats().moves++;
         ClearPlayerPos();
         SetPlayerPos(newPos, dy, dx);
     } else {
@@ -130,10 +149,12 @@ void Sokoban::Regret() {
     auto [lastPlayerPos, dp] = history.top();
     history.pop();
     Pull(lastPlayerPos, -dp);
+    CurStats().undos++;
 }
 
 void Sokoban::SetPlayerPos(Pos p, int dy, int dx) {
     assert(InBound(p));
+    version++;
     playerPos = p;
     Get(playerPos) |= TILE_PLAYER;
     Get(playerPos) &= ~3;
@@ -154,6 +175,7 @@ void Sokoban::Click(Pos pos) {
     if (!IsSpace(pos))
         return;
     if (Accessible(playerPos, pos)) {
+        CurStats().moves++;
         ClearPlayerPos();
         SetPlayerPos(pos, 1, 0);
     }
@@ -184,16 +206,80 @@ bool Sokoban::Accessible(Pos s, Pos t) {
     return accessCache.count(t);
 }
 
-void Sokoban::ProcessEvent(const std::vector<GameEvent>& events,
-                           const Sokoban::Pos& pos) {
-    for (auto e:events) switch (e) {
+void Sokoban::NextLevel() {
+    EnterLevel(curLevel + 1);
+}
+
+void Sokoban::EnterLevel(int level) {
+    auto now = chrono::steady_clock::now();
+    if (clockRunning)
+        CurStats().seconds += chrono::duration<double>(now - enteredAt).count();
+    enteredAt = now;
+    curLevel  = level;
+    LoadLevel(levels[curLevel]);
+}
+
+Sokoban::LevelStats Sokoban::GetLevelStats(int level) const {
+    auto s = stats[level];
+    if (level == curLevel && clockRunning)
+        s.seconds += chrono::duration<double>(chrono::steady_clock::now() - enteredAt).count();
+    return s;
+}
+
+void Sokoban::SetClockRunning(bool running) {
+    if (running == clockRunning)
+        return;
+    auto now = chrono::steady_clock::now();
+    if (clockRunning)
+        CurStats().seconds += chrono::duration<double>(now - enteredAt).count();
+    enteredAt    = now;
+    clockRunning = running;
+}
+
+bool Sokoban::ProcessEvent(const GameEventQueue& events) {
+    auto lastVersion = version;
+    for (size_t i = 0; i < events.Size(); i++) switch (events[i].type) {
         case GameEvent::EVENT_MOVE_UP:      { PushNorth(); } break;
         case GameEvent::EVENT_MOVE_DOWN:    { PushSouth(); } break;
         case GameEvent::EVENT_MOVE_LEFT:    { PushWest();  } break;
         case GameEvent::EVENT_MOVE_RIGHT:   { PushEast();  } break;
         case GameEvent::EVENT_MOVE_RESTART: { Restart();   } break;
         case GameEvent::EVENT_MOVE_REGRET:  { Regret();    } break;
-        case GameEvent::EVENT_MOVE_CLICK:   { Click(pos);  } break; // + row, col
+        case GameEvent::EVENT_MOVE_CLICK:   { Click({events[i].row, events[i].col}); } break;
     }
+    return version != lastVersion;
+}
+
+bool Sokoban::CheckInvariants() const {
+    if (!InBound(playerPos) || !(Get(playerPos) & TILE_PLAYER))
+        return false;
+    int32_t players = 0, boxes = 0, boxesOnTarget = 0;
+    for (auto& row : state) {
+        for (auto tile : row) {
+            if (tile & TILE_BLOCKED) {
+                // walls and the outside hold nothing.
+                if (tile & (TILE_PLAYER | TILE_BOX))
+                    return false;
+                continue;
+            }
+            players       += (tile & TILE_PLAYER) ? 1 : 0;
+            boxes         += (tile & TILE_BOX)    ? 1 : 0;
+            boxesOnTarget += (tile & TILE_BOX) && (tile & TILE_TARGET);
+        }
+    }
+    return players == 1 && !(Get(playerPos) & TILE_BOX) &&
+           boxes == numBoxes && boxesOnTarget == numBoxesOnTarget;
+}
+
+Sokoban Sokoban::Snapshot() const {
+    Sokoban s;
+    s.playerPos        = playerPos;
+    s.state            = state;
+    s.numBoxes         = numBoxes;
+    s.numBoxesOnTarget = numBoxesOnTarget;
+    s.curLevel         = curLevel;
+    s.version          = version;
+    s.analysis         = analysis;
+    return s;
 }
 
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <chrono>
+#include <iosfwd>
+#include <memory>
 #include <stack>
 #include <unordered_set>
 #include <vector>
@@ -44,6 +47,8 @@ enum TileType : uint8_t {
 
 static constexpr const char* ALLOWED_CHARACTERS = " #$@*._+";
 
+struct LevelAnalysis;
+
 class Sokoban {
 public:
 
@@ -59,20 +64,55 @@ public:
             return std::hash<int64_t>()((1LL<<32) * p.row + p.col);
         }
     };
+    // A level parsed at compile time (see game_builtin_levels.hpp).
+    struct ParsedLevel {
+        int32_t         rows  = 0;
+        int32_t         cols  = 0;
+        const TileType* tiles = nullptr;  // rows * cols, row-major.
+        const char*     text  = nullptr;  // first row in the pack's text, rows cols + 1 apart.
+        Pos             player {};
+        int32_t         numBoxes         = 0;
+        int32_t         numBoxesOnTarget = 0;
+    };
     struct Level {
         std::string              name;
-        std::vector<std::string> lines;
+        std::vector<std::string> lines;      // the rows, unless parsed: those stay in the pack's text.
+        ParsedLevel              parsed {};  // if tiles is set, LoadLevel copies them instead of mapping lines.
+
+        int32_t     Rows() const { return parsed.tiles ? parsed.rows : static_cast<int32_t>(lines.size()); }
+        int32_t     Cols() const { return parsed.tiles ? parsed.cols : static_cast<int32_t>(lines[0].size()); }
+        // Cols() characters of the level file.
+        const char* Row(int32_t r) const { return parsed.tiles ? parsed.text + r * (parsed.cols + 1) : lines[r].data(); }
+    };
+    // What players did on a level, since the level pack was loaded.
+    struct LevelStats {
+        uint32_t moves       = 0;  // steps, pushes included; a click-walk is one move.
+        uint32_t pushes      = 0;
+        uint32_t undos       = 0;
+        uint32_t restarts    = 0;
+        uint32_t completions = 0;  // pushes that solved it.
+        double   seconds     = 0;  // played on it while the clock ran, up to now on the current level.
     };
 
     using State = std::vector<std::vector<TileType>>;
 public:
     bool LoadLevels(const char* levelFile);
+    bool LoadLevels(std::istream& in);
     bool LoadLevel(const Level& lines);
     void LoadDefaultLevels();
     int  LoadLevelsFromTxt();
     const State& GetState() const { return state; }
-    void ProcessEvent(const std::vector<GameEvent>& events, const Pos& pos);
-    void Restart  (){ LoadLevel(levels[curLevel]); }
+    const LevelAnalysis& GetAnalysis() const { return *analysis; }
+    Pos  GetPlayerPos() const { return playerPos; }
+    int  GetNumPushes() const { return static_cast<int>(history.size()); }
+    // Bumped on every change of the state, so observers can tell it is stale.
+    uint32_t GetVersion() const { return version; }
+    // Copy of the current position only: no level pack, no undo history.
+    // Cheap enough to hand over to another thread, and enough to search on.
+    Sokoban Snapshot() const;
+    // Apply all queued events, without consuming them. Return whether the state changed.
+    bool ProcessEvent(const GameEventQueue& events);
+    void Restart  (){ CurStats().restarts++; LoadLevel(levels[curLevel]); }
     void PushNorth(){ Push(-1, 0); }
     void PushSouth(){ Push( 1, 0); }
     void PushEast (){ Push( 0, 1); }
@@ -81,12 +121,27 @@ public:
     void Click(Pos pos);
     void Regret();
     bool IsLastLevel() const { return curLevel == levels.size() - 1; }
-    void NextLevel() { curLevel++; Restart(); }
+    void NextLevel();
     int  GetCurLevel() const { return curLevel; }
     std::string GetCurLevelName() const { return levels[curLevel].name; }
+    int  GetNumLevels() const { return static_cast<int>(levels.size()); }
+    const std::string& GetLevelName(int level) const { return levels[level].name; }
+    const Level& GetLevel(int level) const { return levels[level]; }
+    LevelStats GetLevelStats(int level) const;
+    // The time on the current level only adds up while the clock runs: the
+    // GUI stops it off the game scene (menus, pause, level finished).
+    void SetClockRunning(bool running);
     bool LevelCompleted() const { return numBoxes == numBoxesOnTarget; }
+    // Compact binary copy of the session on the current level: which level,
+    // where the boxes and the player are, and the undo history (see game_session.hpp).
+    // Restore() only takes what was saved on the same level, else it changes nothing.
+    void Save(std::vector<uint8_t>& out) const;
+    bool Restore(const uint8_t* data, size_t size);
+    // Recount the board: exactly one player, at playerPos, and the box
+    // counters match. Unlike the asserts, this runs in any build.
+    bool CheckInvariants() const;
 private:
-    bool LoadLevelFromFile(const char* levelFile);
+    bool LoadLevelFromFile(std::istream& in);
     void Pull(Pos LastPlayerPos, Pos dp);
     const TileType& Get(Pos p) const {return state[p.row][p.col]; }
     TileType& Get(Pos p) {return state[p.row][p.col]; }
@@ -100,14 +155,34 @@ private:
     void ClearPlayerPos();
     void SetPlayerPos(Pos p, int dy, int dx);
     void Clear() {numBoxes = numBoxesOnTarget = 0; history={}; accessCache.clear();}
+    // Fixed-size counters, sized with the level pack: nothing allocates on the move path.
+    // Snapshots have no level pack, their counts go nowhere.
+    LevelStats& CurStats() { return curLevel < stats.size() ? stats[curLevel] : discardedStats; }
+    void EnterLevel(int level);
+    // Per-level state of a freshly loaded pack.
+    void ResetPack() {
+        stats.assign(levels.size(), {});
+        analyses.assign(levels.size(), nullptr);
+        enteredAt = std::chrono::steady_clock::now();
+    }
+    std::shared_ptr<const LevelAnalysis> Analyze(const Level& level);
 private:
     Pos   playerPos;
     State state;
     int32_t numBoxes;         // set on LoadLevel and never changes.
     int32_t numBoxesOnTarget; // updated on LoadLevel and MoveBox
     std::vector<Level> levels;
-    int curLevel;
+    int curLevel = 0;
+    uint32_t version = 0;
+    std::vector<LevelStats> stats;
+    LevelStats discardedStats;
+    std::chrono::steady_clock::time_point enteredAt;  // of the current level, or since the clock last started.
+    bool clockRunning = true;
     // After each push, history contains new player Pos and dp
     std::stack<std::pair<Pos,Pos>> history;
     std::unordered_set<Pos, PosHash> accessCache;
+    // Computed on LoadLevel, shared with whoever searches on this level.
+    std::shared_ptr<const LevelAnalysis> analysis;
+    // Of each level of the pack, from its first load on.
+    std::vector<std::shared_ptr<const LevelAnalysis>> analyses;
 };
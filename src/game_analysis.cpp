@@ -0,0 +1,234 @@
+#include "game_analysis.hpp"
+
+#include <algorithm>
+#include <queue>
+
+using namespace std;
+
+// A box can only ever be pushed, so run the pushes backwards (pulls) from
+// every goal cell. Any floor cell never reached is dead w.r.t. those goals.
+vector<int32_t> PushDistance(const LevelAnalysis& a, const vector<uint8_t>& goal) {
+    vector<int32_t> distance(a.NumCells(), LevelAnalysis::UNREACHABLE);
+    queue<int32_t> q;
+    for (int32_t c = 0; c < a.NumCells(); c++) {
+        if (goal[c]) {
+            distance[c] = 0;
+            q.push(c);
+        }
+    }
+    while (q.size()) {
+        auto c = q.front();
+        q.pop();
+        for (int d = 0; d < NUM_DIRS; d++) {
+            // box came from `from` by a push along d, player stood at `from - delta`.
+            int32_t from   = c    - a.delta[d];
+            int32_t player = from - a.delta[d];
+            if (!a.floor[from] || !a.floor[player] || distance[from] != LevelAnalysis::UNREACHABLE)
+                continue;
+            distance[from] = distance[c] + 1;
+            q.push(from);
+        }
+    }
+    return distance;
+}
+
+static void ComputeDistance(LevelAnalysis& a) {
+    a.distance = PushDistance(a, a.target);
+    a.dead.assign(a.NumCells(), 0);
+    for (int32_t c = 0; c < a.NumCells(); c++) {
+        a.dead[c] = a.floor[c] && a.distance[c] == LevelAnalysis::UNREACHABLE;
+    }
+}
+
+// A box pushed along d into c, where both c and the cell behind it (where the
+// player stands) are walled on both sides, can't be reached from anywhere but
+// straight behind. Stopping halfway only blocks the tunnel, so keep pushing.
+static void ComputeTunnels(LevelAnalysis& a) {
+    a.tunnel.assign(a.NumCells(), 0);
+    for (int32_t c = 0; c < a.NumCells(); c++) {
+        if (!a.floor[c])
+            continue;
+        for (int d = 0; d < NUM_DIRS; d++) {
+            int32_t behind = c - a.delta[d];
+            int32_t side0  = a.delta[d ^ 1];
+            int32_t side1  = -side0;
+            if (a.floor[behind] &&
+                !a.floor[c + side0]      && !a.floor[c + side1] &&
+                !a.floor[behind + side0] && !a.floor[behind + side1]) {
+                a.tunnel[c] |= (1 << d);
+            }
+        }
+    }
+}
+
+// Tarjan, iteratively (a generated 500x500 level would blow the stack),
+// rooted at the player. A subtree whose low-link doesn't reach above its
+// parent is cut off by that parent; if it holds targets but no boxes, it is
+// a goal room and the parent is its entrance.
+static void ComputeGoalRooms(LevelAnalysis& a, int32_t root, const vector<uint8_t>& box) {
+    const int32_t n = a.NumCells();
+    vector<int32_t> disc(n, -1), low(n), parent(n, -1), last(n);
+    vector<int32_t> order; // preorder, so that subtree(v) = order[disc[v] .. last[v]]
+    vector<pair<int32_t,int>> stack;
+
+    a.articulation.assign(n, 0);
+    int rootChildren = 0;
+    disc[root] = low[root] = 0;
+    order.push_back(root);
+    stack.push_back({root, 0});
+    while (stack.size()) {
+        auto [c, d] = stack.back();
+        if (d < NUM_DIRS) {
+            stack.back().second++;
+            int32_t next = c + a.delta[d];
+            if (!a.floor[next])
+                continue;
+            if (disc[next] < 0) {
+                disc[next] = low[next] = static_cast<int32_t>(order.size());
+                parent[next] = c;
+                order.push_back(next);
+                rootChildren += (c == root);
+                stack.push_back({next, 0});
+            } else if (next != parent[c]) {
+                low[c] = min(low[c], disc[next]);
+            }
+            continue;
+        }
+        int32_t v = c;
+        last[v] = static_cast<int32_t>(order.size()) - 1;
+        stack.pop_back();
+        if (int32_t p = parent[v]; p >= 0) {
+            low[p] = min(low[p], low[v]);
+            if (p != root && low[v] >= disc[p])
+                a.articulation[p] = true;
+        }
+    }
+    a.articulation[root] = rootChildren > 1;
+
+    // prefix sums over preorder to count targets and boxes of any subtree in O(1).
+    vector<int32_t> targets(order.size() + 1), boxes(order.size() + 1);
+    for (size_t i = 0; i < order.size(); i++) {
+        targets[i+1] = targets[i] + a.target[order[i]];
+        boxes  [i+1] = boxes  [i] + box[order[i]];
+    }
+
+    a.goalRoom.assign(n, -1);
+    a.goalRooms.clear();
+    int32_t coveredUntil = 0; // subtrees are nested or disjoint, keep the outermost.
+    for (int32_t i = 1; i < static_cast<int32_t>(order.size()); i++) {
+        int32_t v = order[i];
+        int32_t p = parent[v];
+        if (i <= coveredUntil || low[v] < disc[p] || a.target[p])
+            continue;
+        if (targets[last[v]+1] - targets[i] == 0 || boxes[last[v]+1] - boxes[i] != 0)
+            continue;
+        coveredUntil = last[v];
+
+        LevelAnalysis::GoalRoom room;
+        room.entrance = p;
+        room.cells.assign(order.begin() + i, order.begin() + last[v] + 1);
+        auto roomIndex = static_cast<int16_t>(a.goalRooms.size());
+        for (auto c : room.cells)
+            a.goalRoom[c] = roomIndex;
+
+        // fill order: deepest target (walking from the entrance) first.
+        vector<int32_t> depth(n, -1);
+        queue<int32_t>  q;
+        depth[p] = 0;
+        q.push(p);
+        while (q.size()) {
+            auto c = q.front();
+            q.pop();
+            for (auto delta : a.delta) {
+                auto next = c + delta;
+                if (a.goalRoom[next] != roomIndex || depth[next] >= 0)
+                    continue;
+                depth[next] = depth[c] + 1;
+                q.push(next);
+            }
+        }
+        for (auto c : room.cells)
+            if (a.target[c])
+                room.fillOrder.push_back(c);
+        stable_sort(room.fillOrder.begin(), room.fillOrder.end(), [&depth](int32_t x, int32_t y) {
+            return depth[x] > depth[y];
+        });
+        a.goalRooms.push_back(std::move(room));
+    }
+}
+
+LevelAnalysis AnalyzeLevel(const Sokoban::State& state) {
+    LevelAnalysis a;
+    a.rows  = static_cast<int32_t>(state.size());
+    a.cols  = static_cast<int32_t>(state[0].size());
+    for (int d = 0; d < NUM_DIRS; d++)
+        a.delta[d] = DIR_POS[d].row * a.cols + DIR_POS[d].col;
+
+    const int32_t n = a.NumCells();
+    int32_t player = 0;
+    vector<uint8_t> box(n);
+    for (int32_t c = 0; c < n; c++) {
+        auto tile = state[c / a.cols][c % a.cols];
+        if (tile & TILE_PLAYER)
+            player = c;
+        box[c] = (tile & TILE_BOX) != 0;
+    }
+
+    // floor: flood fill from the player, boxes don't count as obstacles.
+    a.floor.assign(n, 0);
+    a.target.assign(n, 0);
+    queue<int32_t> q;
+    a.floor[player] = true;
+    q.push(player);
+    while (q.size()) {
+        auto c = q.front();
+        q.pop();
+        a.target[c] = (state[c / a.cols][c % a.cols] & TILE_TARGET) != 0;
+        for (int d = 0; d < NUM_DIRS; d++) {
+            auto p = a.ToPos(c) + DIR_POS[d];
+            if (p.row < 0 || p.row >= a.rows || p.col < 0 || p.col >= a.cols)
+                continue;
+            auto next = c + a.delta[d];
+            if (a.floor[next] || (state[p.row][p.col] & TILE_BLOCKED))
+                continue;
+            a.floor[next] = true;
+            q.push(next);
+        }
+    }
+
+    // bitboard layout: walls and outside cells around the floor's bounding box get no bits.
+    int32_t top = a.rows, bottom = 0, left = a.cols, right = 0;
+    for (int32_t c = 0; c < n; c++) {
+        if (a.floor[c]) {
+            top    = min(top,    c / a.cols);
+            bottom = max(bottom, c / a.cols);
+            left   = min(left,   c % a.cols);
+            right  = max(right,  c % a.cols);
+        }
+    }
+    const int32_t stride  = right - left + 2;
+    const int32_t numBits = (bottom - top + 1) * stride;
+    for (size_t words = 1; words <= MAX_BOARD_WORDS && !a.boardWords; words *= 2)
+        if (numBits <= static_cast<int32_t>(64 * words))
+            a.boardWords = static_cast<int32_t>(words);
+    if (a.boardWords) {
+        a.boardStride = stride;
+        a.bitOf.assign(n, stride - 1);
+        a.bitCell.assign(numBits, 0);
+        for (int32_t row = top; row <= bottom; row++) {
+            for (int32_t col = left; col <= right; col++) {
+                auto c   = row * a.cols + col;
+                auto bit = (row - top) * stride + col - left;
+                a.bitOf[c]     = bit;
+                a.bitCell[bit] = c;
+                if (a.floor[c])
+                    a.floorBits.Set(bit);
+            }
+        }
+    }
+
+    ComputeDistance(a);
+    ComputeTunnels(a);
+    ComputeGoalRooms(a, player, box);
+    return a;
+}
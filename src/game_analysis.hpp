@@ -0,0 +1,88 @@
+#pragma once
+
+#include "game.hpp"
+#include "game_bitboard.hpp"
+
+#include <array>
+#include <initializer_list>
+#include <vector>
+#include <cstdint>
+
+// Static facts about a level, i.e., everything that doesn't depend on where
+// the boxes and the player are. Computed once per LoadLevel and shared
+// (read-only) by the solver and anything else that searches.
+//
+// Cells are addressed by index = row * cols + col.
+// All floor cells are strictly inside the level (LoadOneLevel ensures the
+// wall is closed), so cell + delta[d] never needs a bound check.
+
+// Directions in LURD order, so that "lurd"[d] is the move letter.
+enum Dir : uint8_t { DIR_LEFT, DIR_UP, DIR_RIGHT, DIR_DOWN, NUM_DIRS };
+
+static constexpr const char* LURD = "lurd";
+static constexpr std::array<Sokoban::Pos, NUM_DIRS> DIR_POS = {{{0,-1}, {-1,0}, {0,1}, {1,0}}};
+
+static constexpr Dir Opposite(Dir d) { return static_cast<Dir>(d ^ 2); }
+
+struct LevelAnalysis {
+    static constexpr int32_t UNREACHABLE = INT32_MAX;
+
+    struct GoalRoom {
+        int32_t              entrance;  // the only cell connecting the room to the rest of the level.
+        std::vector<int32_t> cells;     // floor cells of the room, entrance excluded.
+        std::vector<int32_t> fillOrder; // targets of the room, deepest first.
+    };
+
+    int32_t rows = 0;
+    int32_t cols = 0;
+    std::array<int32_t, NUM_DIRS> delta {};
+
+    std::vector<uint8_t> floor;        // reachable from the player, boxes ignored.
+    std::vector<uint8_t> target;
+    std::vector<uint8_t> dead;         // box here can never reach any target.
+    std::vector<uint8_t> articulation; // removing this cell splits the floor.
+    std::vector<uint8_t> tunnel;       // bit d: a box pushed into this cell along d has to keep going.
+    std::vector<int16_t> goalRoom;     // index into goalRooms, -1 if not in a room.
+    std::vector<int32_t> distance;     // min pushes to the nearest target, ignoring other boxes.
+    std::vector<GoalRoom> goalRooms;
+
+    // Bitboards cover the bounding box of the floor, row by row, with one
+    // spare column per row: bit (row - top) * boardStride + (col - left).
+    // boardWords: 1, 2 or 4 if that fits a Bitboard of as many words, 0 if too big for one.
+    int32_t              boardWords  = 0;
+    int32_t              boardStride = 0;
+    std::vector<int32_t> bitOf;    // bit of each cell; cells off the box get a spare, never set, bit.
+    std::vector<int32_t> bitCell;  // cell of each bit.
+    MaxBitboard          floorBits;
+
+    int32_t NumCells() const { return rows * cols; }
+    int32_t Cell(Sokoban::Pos p) const { return p.row * cols + p.col; }
+    Sokoban::Pos ToPos(int32_t cell) const { return {cell / cols, cell % cols}; }
+};
+
+LevelAnalysis AnalyzeLevel(const Sokoban::State& state);
+
+// Min pushes for a box at each cell to reach any cell of `goal`, other boxes ignored.
+std::vector<int32_t> PushDistance(const LevelAnalysis& a, const std::vector<uint8_t>& goal);
+
+// Box at `c` completes a 2x2 block of walls and boxes, not all on targets:
+// none of them can ever move again. Rows are `stride` cells apart, so this
+// works on the solver's cells and on VecSokoban's padded boards alike.
+template <class Wall, class Box, class Target>
+bool IsFrozenSquare(int32_t c, int32_t stride, Wall wall, Box box, Target target) {
+    for (auto dr : {-stride, stride}) {
+        for (auto dc : {-1, 1}) {
+            bool frozen = true;
+            bool allOnTarget = true;
+            for (auto x : {c, c + dr, c + dc, c + dr + dc}) {
+                if (box(x))
+                    allOnTarget &= target(x);
+                else
+                    frozen &= wall(x);
+            }
+            if (frozen && !allOnTarget)
+                return true;
+        }
+    }
+    return false;
+}
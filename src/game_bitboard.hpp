@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// A set of cells in WORDS 64-bit words, laid out over the bounding box of the
+// floor (LevelAnalysis::bitOf). Levels whose box, plus a spare column, has up
+// to 64, 128 or 256 cells get a Bitboard<1>, <2> or <4>; LevelAnalysis::boardWords
+// tells which, and the solver picks the matching instance once per search.
+//
+// A step is a shift by 1 or LevelAnalysis::boardStride: the spare column
+// keeps bits from wrapping into the next row, so a whole flood fill front
+// moves in a few integer ops per word.
+static inline int32_t LowestBit(uint64_t x) {
+#if defined(_MSC_VER)
+    unsigned long i;
+    _BitScanForward64(&i, x);
+    return static_cast<int32_t>(i);
+#else
+    return __builtin_ctzll(x);
+#endif
+}
+
+template <size_t WORDS>
+struct Bitboard {
+    static constexpr int32_t CAPACITY = 64 * WORDS;
+
+    uint64_t w[WORDS] {};
+
+    bool Test (int32_t c) const { return (w[c >> 6] >> (c & 63)) & 1; }
+    void Set  (int32_t c)       { w[c >> 6] |=   1ULL << (c & 63);  }
+    void Reset(int32_t c)       { w[c >> 6] &= ~(1ULL << (c & 63)); }
+
+    bool Any() const {
+        uint64_t any = 0;
+        for (size_t i = 0; i < WORDS; i++)
+            any |= w[i];
+        return any != 0;
+    }
+    // The smallest cell in the set, which must not be empty.
+    int32_t Lowest() const {
+        size_t i = 0;
+        while (!w[i])
+            i++;
+        return static_cast<int32_t>(64 * i) + LowestBit(w[i]);
+    }
+    template <typename F>
+    void ForEach(F&& f) const {
+        for (size_t i = 0; i < WORDS; i++)
+            for (auto bits = w[i]; bits; bits &= bits - 1)
+                f(static_cast<int32_t>(64 * i) + LowestBit(bits));
+    }
+
+    // Every cell moved by n, up (n > 0) or down (n < 0).
+    Bitboard Shift(int32_t n) const {
+        Bitboard r;
+        const bool   up   = n > 0;
+        const size_t q    = static_cast<size_t>(up ? n : -n) / 64;
+        const int    bits = (up ? n : -n) % 64;
+        for (size_t i = 0; i < WORDS; i++) {
+            if (up) {
+                r.w[i] = (i >= q ? w[i - q] << bits : 0) |
+                         (bits && i > q ? w[i - q - 1] >> (64 - bits) : 0);
+            } else {
+                r.w[i] = (i + q < WORDS ? w[i + q] >> bits : 0) |
+                         (bits && i + q + 1 < WORDS ? w[i + q + 1] << (64 - bits) : 0);
+            }
+        }
+        return r;
+    }
+
+    Bitboard operator|(const Bitboard& b) const { Bitboard r; for (size_t i = 0; i < WORDS; i++) r.w[i] = w[i] | b.w[i]; return r; }
+    Bitboard operator&(const Bitboard& b) const { Bitboard r; for (size_t i = 0; i < WORDS; i++) r.w[i] = w[i] & b.w[i]; return r; }
+    Bitboard operator~()                  const { Bitboard r; for (size_t i = 0; i < WORDS; i++) r.w[i] = ~w[i];         return r; }
+    Bitboard& operator|=(const Bitboard& b) { return *this = *this | b; }
+};
+
+// The largest instance, big enough to hold any of them.
+static constexpr size_t MAX_BOARD_WORDS = 4;
+using MaxBitboard = Bitboard<MAX_BOARD_WORDS>;
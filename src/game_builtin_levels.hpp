@@ -0,0 +1,186 @@
+#pragma once
+
+#include "game.hpp"
+
+#include <string>
+#include <vector>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+// A level file character as a tile.
+static constexpr TileType TxtMap(char c) {
+    switch (c) {
+    case ' ': return TILE_SPACE;
+    case '#': return TILE_WALL;
+    case '$': return TILE_BOX;
+    case '@': return TILE_PLAYER;
+    case '*': return TILE_BOX_ON_TARGET;
+    case '.': return TILE_TARGET;
+    case '+': return TILE_PLAYER_ON_TARGET;
+    default:
+        assert(c == '_');
+        return TILE_NULL;
+    }
+}
+
+// Level packs built into the binary, parsed by the compiler.
+//
+// A pack is a string literal in the level file format, with levels already
+// normalized the way LoadLevels leaves them: every row as long as the
+// others, '_' outside the walls. Each level is a name line, then its rows,
+// then a blank line. Parse() turns it into TileType tables, with the player
+// and the box counts, at compile time:
+//
+//   static constexpr char LEVELS[] = R"(
+//   name
+//   #####
+//   #@$.#
+//   #####
+//   )";
+//   static constexpr auto PACK = Parse<NumLevels(LEVELS), NumCells(LEVELS)>(LEVELS);
+//
+// A malformed level, or one whose wall lets the player out, makes Parse()
+// call BadLevel(), which isn't constexpr, so it fails the build instead of
+// the game. Loading a parsed level is a copy.
+namespace GameBuiltin {
+
+struct Entry {
+    size_t       name     = 0;  // offset of the name line in the text.
+    size_t       nameSize = 0;
+    size_t       lines    = 0;  // offset of the first row, rows are cols + 1 ('\n') apart.
+    int32_t      rows     = 0;
+    int32_t      cols     = 0;
+    size_t       tiles    = 0;  // offset in Pack::tiles.
+    Sokoban::Pos player   {};
+    int32_t      numBoxes         = 0;
+    int32_t      numBoxesOnTarget = 0;
+};
+
+template <size_t NUM_LEVELS, size_t NUM_CELLS>
+struct Pack {
+    const char* text = nullptr;
+    Entry       levels[NUM_LEVELS] {};
+    TileType    tiles [NUM_CELLS]  {};
+};
+
+// Not constexpr: reaching it at compile time is the error message.
+inline void BadLevel(const char* /*why*/) {}
+
+static constexpr size_t LineEnd(const char* text, size_t at) {
+    while (text[at] && text[at] != '\n')
+        at++;
+    return at;
+}
+
+// Call f(entry) with the layout of every level: name, rows and cols.
+template <typename F>
+static constexpr void ForEachLevel(const char* text, F&& f) {
+    size_t at = 0;
+    while (true) {
+        while (text[at] == '\n')
+            at++;
+        if (!text[at])
+            return;
+        Entry e;
+        e.name     = at;
+        e.nameSize = LineEnd(text, at) - at;
+        at         = e.name + e.nameSize + (text[e.name + e.nameSize] ? 1 : 0);
+        e.lines    = at;
+        e.cols     = static_cast<int32_t>(LineEnd(text, at) - at);
+        while (text[at] && text[at] != '\n') {
+            if (static_cast<int32_t>(LineEnd(text, at) - at) != e.cols)
+                BadLevel("rows of different lengths");
+            e.rows++;
+            at = LineEnd(text, at);
+            at += text[at] ? 1 : 0;
+        }
+        if (e.rows < 3 || e.cols < 3)
+            BadLevel("level too small");
+        f(e);
+    }
+}
+
+static constexpr size_t NumLevels(const char* text) {
+    size_t n = 0;
+    ForEachLevel(text, [&n](const Entry&) { n++; });
+    return n;
+}
+
+static constexpr size_t NumCells(const char* text) {
+    size_t n = 0;
+    ForEachLevel(text, [&n](const Entry& e) { n += e.rows * e.cols; });
+    return n;
+}
+
+template <size_t NUM_LEVELS, size_t NUM_CELLS>
+static constexpr Pack<NUM_LEVELS, NUM_CELLS> Parse(const char* text) {
+    Pack<NUM_LEVELS, NUM_CELLS> pack;
+    pack.text = text;
+    size_t level = 0, cell = 0;
+    ForEachLevel(text, [&](Entry e) {
+        e.tiles = cell;
+        int32_t numPlayers = 0, numTargets = 0;
+        for (int32_t r = 0; r < e.rows; r++) {
+            for (int32_t c = 0; c < e.cols; c++) {
+                char ch = text[e.lines + r * (e.cols + 1) + c];
+                bool allowed = false;
+                for (auto a = ALLOWED_CHARACTERS; *a; a++)
+                    allowed |= *a == ch;
+                if (!allowed)
+                    BadLevel("not a level character");
+                auto tile = TxtMap(ch);
+                if (tile & TILE_PLAYER) {
+                    numPlayers++;
+                    e.player = {r, c};
+                }
+                e.numBoxes         += (tile & TILE_BOX) ? 1 : 0;
+                e.numBoxesOnTarget += (tile & TILE_BOX) && (tile & TILE_TARGET);
+                numTargets         += (tile & TILE_TARGET) ? 1 : 0;
+                pack.tiles[cell++] = tile;
+            }
+        }
+        if (numPlayers != 1 || e.numBoxes != numTargets)
+            BadLevel("needs one player, as many boxes as targets");
+
+        // the wall must be closed: walking from the player never gets to the edge, nor outside.
+        bool    seen [NUM_CELLS] {};
+        int32_t queue[NUM_CELLS] {};
+        size_t  head = 0, tail = 0;
+        queue[tail++] = e.player.row * e.cols + e.player.col;
+        seen[queue[0]] = true;
+        while (head < tail) {
+            auto c = queue[head++];
+            auto r = c / e.cols, col = c % e.cols;
+            if (r == 0 || r == e.rows - 1 || col == 0 || col == e.cols - 1 || pack.tiles[e.tiles + c] == TILE_NULL) {
+                BadLevel("wall not closed");
+                continue;
+            }
+            const int32_t next[] = {c - 1, c + 1, c - e.cols, c + e.cols};
+            for (auto n : next) {
+                if (!seen[n] && pack.tiles[e.tiles + n] != TILE_WALL) {
+                    seen[n] = true;
+                    queue[tail++] = n;
+                }
+            }
+        }
+        pack.levels[level++] = e;
+    });
+    return pack;
+}
+
+// The levels of a pack, ready for Sokoban. Only the names are copied out of
+// the text; rows are read in place (Level::Row), and no tile is mapped.
+template <size_t NUM_LEVELS, size_t NUM_CELLS>
+std::vector<Sokoban::Level> Levels(const Pack<NUM_LEVELS, NUM_CELLS>& pack) {
+    std::vector<Sokoban::Level> levels(NUM_LEVELS);
+    for (size_t i = 0; i < NUM_LEVELS; i++) {
+        const auto& e = pack.levels[i];
+        auto& level   = levels[i];
+        level.name.assign(pack.text + e.name, e.nameSize);
+        level.parsed = {e.rows, e.cols, pack.tiles + e.tiles, pack.text + e.lines, e.player, e.numBoxes, e.numBoxesOnTarget};
+    }
+    return levels;
+}
+
+}
@@ -4,7 +4,7 @@
 
 namespace GameConfig {
 
-enum { Up, Down, Right, Left, Restart, Regret, NUM_BINDINGS };
+enum { Up, Down, Right, Left, Restart, Regret, Hint, ZoomIn, ZoomOut, NUM_BINDINGS };
 
 // gcc doesn't support non-trivial designated initializers not supported
 static Binding bindings[NUM_BINDINGS] {
@@ -14,6 +14,9 @@ static Binding bindings[NUM_BINDINGS] {
     /*[Left   ] = */ {KEY_LEFT , KEY_J, KEY_A, KEY_NULL},
     /*[Restart] = */ {KEY_R},
     /*[Regret ] = */ {KEY_Z},
+    /*[Hint   ] = */ {KEY_H},
+    /*[ZoomIn ] = */ {KEY_EQUAL, KEY_KP_ADD},
+    /*[ZoomOut] = */ {KEY_MINUS, KEY_KP_SUBTRACT},
 };
 
 static bool Contain(Binding b, int key) {
@@ -26,5 +29,8 @@ bool IsRight  (int key) { return key != KEY_NULL && Contain(bindings[Right],   k
 bool IsLeft   (int key) { return key != KEY_NULL && Contain(bindings[Left],    key); }
 bool IsRestart(int key) { return key != KEY_NULL && Contain(bindings[Restart], key); }
 bool IsRegret (int key) { return key != KEY_NULL && Contain(bindings[Regret],  key); }
+bool IsHint   (int key) { return key != KEY_NULL && Contain(bindings[Hint],    key); }
+bool IsZoomIn (int key) { return key != KEY_NULL && Contain(bindings[ZoomIn],  key); }
+bool IsZoomOut(int key) { return key != KEY_NULL && Contain(bindings[ZoomOut], key); }
 
 }
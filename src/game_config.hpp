@@ -13,5 +13,8 @@ bool IsRight  (int key);
 bool IsLeft   (int key);
 bool IsRestart(int key);
 bool IsRegret (int key);
+bool IsHint   (int key);
+bool IsZoomIn (int key);
+bool IsZoomOut(int key);
 
 }
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
 // Suppose you have a 2D FPS game,
 //
 // GameEvent actually consists of 2 components,
@@ -40,6 +44,50 @@ enum class GameEvent {
     EVENT_MOVE_CLICK, // + row, col
 };
 
+// A GameEvent with its own payload, and when it was polled.
+struct TimedGameEvent {
+    GameEvent type;
+    int       row, col;  // the cell clicked, EVENT_MOVE_CLICK only.
+    double    time;      // seconds (raylib GetTime()) when raylib polled the input.
+};
+
+// The events of a frame, in order. Fixed capacity and reused frame after
+// frame, so reading input never allocates. When full, new events are dropped
+// (and counted): nobody presses 64 keys in one frame.
+class GameEventQueue {
+public:
+    static constexpr size_t CAPACITY = 64;
+
+    bool Push(const TimedGameEvent& e) {
+        if (count == CAPACITY) {
+            dropped++;
+            return false;
+        }
+        events[(head + count++) % CAPACITY] = e;
+        return true;
+    }
+    bool Pop(TimedGameEvent& e) {
+        if (count == 0)
+            return false;
+        e    = events[head];
+        head = (head + 1) % CAPACITY;
+        count--;
+        return true;
+    }
+    // i-th oldest event, without consuming it.
+    const TimedGameEvent& operator[](size_t i) const { return events[(head + i) % CAPACITY]; }
+    size_t   Size()    const { return count;   }
+    bool     Empty()   const { return !count;  }
+    uint64_t Dropped() const { return dropped; }
+    void     Clear() { head = count = 0; }
+
+private:
+    std::array<TimedGameEvent, CAPACITY> events;
+    size_t   head    = 0;
+    size_t   count   = 0;
+    uint64_t dropped = 0;
+};
+
 enum class GuiEvent {
     // menu
     EVENT_NULL,
@@ -50,4 +98,8 @@ enum class GuiEvent {
     EVENT_MENU_LEVEL_FINISHED,
     EVENT_MENU_NEXT_LEVEL,
     EVENT_MENU_EXIT,
+    // in game
+    EVENT_HINT,
+    EVENT_ZOOM_IN,
+    EVENT_ZOOM_OUT,
 };
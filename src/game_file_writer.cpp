@@ -0,0 +1,81 @@
+#include "game_file_writer.hpp"
+
+#include <filesystem>
+#include <cstdio>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// Get what's been written to `fout` onto the disk, not just into the OS cache.
+static bool Sync(FILE* fout) {
+#if defined(_WIN32)
+    return _commit(_fileno(fout)) == 0;
+#else
+    return fsync(fileno(fout)) == 0;
+#endif
+}
+
+BackgroundFileWriter::BackgroundFileWriter(string file) : file(std::move(file)) {
+#if !defined(PLATFORM_WEB)
+    worker = thread(&BackgroundFileWriter::Run, this);
+#endif
+}
+
+BackgroundFileWriter::~BackgroundFileWriter() {
+    if (!worker.joinable())
+        return;
+    {
+        lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wakeUp.notify_one();
+    worker.join();
+}
+
+void BackgroundFileWriter::Submit(const void* data, size_t size) {
+    auto bytes = static_cast<const char*>(data);
+#if defined(PLATFORM_WEB)
+    pending.assign(bytes, bytes + size);
+    Write(pending);
+#else
+    {
+        lock_guard<std::mutex> lock(mutex);
+        pending.assign(bytes, bytes + size);
+        hasPending = true;
+    }
+    wakeUp.notify_one();
+#endif
+}
+
+void BackgroundFileWriter::Write(const vector<char>& data) {
+    auto temporary = file + ".tmp";
+    FILE* fout = fopen(temporary.c_str(), "wb");
+    if (!fout)
+        return;
+    // synced before the rename, or a power cut could leave the new name on unwritten data.
+    bool written = fwrite(data.data(), 1, data.size(), fout) == data.size() && fflush(fout) == 0 && Sync(fout);
+    if (fclose(fout) != 0 || !written)
+        return;
+    error_code error;
+    filesystem::rename(temporary, file, error);
+}
+
+void BackgroundFileWriter::Run() {
+    vector<char> data;
+    while (true) {
+        {
+            unique_lock<std::mutex> lock(mutex);
+            wakeUp.wait(lock, [this] { return quit || hasPending; });
+            if (!hasPending)
+                return;
+            data.swap(pending);
+            hasPending = false;
+        }
+        Write(data);
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstddef>
+
+// Rewrites a whole file on a background thread, so the main loop never waits
+// on the disk. The contents go to a temporary file, synced to the disk and
+// then renamed over the old one, so a crash never leaves half a file. Only the latest contents not yet
+// written are kept. On the web there is no thread, it writes right away.
+class BackgroundFileWriter {
+public:
+    explicit BackgroundFileWriter(std::string file);
+    // Write what's left before leaving.
+    ~BackgroundFileWriter();
+    BackgroundFileWriter(const BackgroundFileWriter&) = delete;
+    BackgroundFileWriter& operator=(const BackgroundFileWriter&) = delete;
+
+    // Copy `data` and return. Doesn't allocate once the buffers are big enough.
+    void Submit(const void* data, size_t size);
+
+private:
+    void Write(const std::vector<char>& data);
+    void Run();
+
+    std::string             file;
+    std::mutex              mutex;  // guards pending, hasPending and quit.
+    std::condition_variable wakeUp;
+    std::vector<char>       pending;
+    bool                    hasPending = false;
+    bool                    quit       = false;
+    std::thread             worker;
+};
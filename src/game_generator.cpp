@@ -0,0 +1,200 @@
+#include "game_generator.hpp"
+#include "game_analysis.hpp"
+#include "game_solver.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+
+using namespace std;
+
+namespace GameGenerator {
+
+// A level in the making: one character per cell, as in a level file.
+struct Candidate {
+    int32_t      rows, cols;
+    string       cells;
+    int32_t      player;
+    const int32_t delta[NUM_DIRS];
+
+    Candidate(int32_t rows, int32_t cols)
+        : rows(rows), cols(cols), cells(rows * cols, '#'), player(0), delta{-1, -cols, 1, cols} {}
+    bool IsFloor(int32_t c) const { return cells[c] != '#'; }
+    bool IsBox  (int32_t c) const { return cells[c] == '$' || cells[c] == '*'; }
+    bool IsFree (int32_t c) const { return IsFloor(c) && !IsBox(c); }
+    void MoveBox(int32_t from, int32_t to) {
+        cells[from] = cells[from] == '*' ? '.' : ' ';
+        cells[to]   = cells[to]   == '.' ? '*' : '$';
+    }
+    Sokoban::Level ToLevel(const string& name) const {
+        Sokoban::Level level {name, {}};
+        for (int32_t r = 0; r < rows; r++)
+            level.lines.push_back(cells.substr(r * cols, cols));
+        auto& c = level.lines[player / cols][player % cols];
+        c = c == '.' ? '+' : '@';
+        return level;
+    }
+};
+
+// Cells reachable from `from` without crossing a wall, or a box when `boxesBlock`.
+static vector<int32_t> Flood(const Candidate& level, int32_t from, bool boxesBlock, vector<uint8_t>& seen) {
+    seen.assign(level.cells.size(), 0);
+    vector<int32_t> region {from};
+    seen[from] = true;
+    for (size_t i = 0; i < region.size(); i++)
+        for (auto d : level.delta) {
+            auto next = region[i] + d;
+            if (!seen[next] && (boxesBlock ? level.IsFree(next) : level.IsFloor(next))) {
+                seen[next] = true;
+                region.push_back(next);
+            }
+        }
+    return region;
+}
+
+// A random room with all boxes on targets, or false if the walls left too little floor.
+static bool MakeRoom(Candidate& level, const Options& options, mt19937_64& rng) {
+    bernoulli_distribution isWall(options.wallDensity);
+    for (int32_t r = 1; r < level.rows - 1; r++)
+        for (int32_t c = 1; c < level.cols - 1; c++)
+            level.cells[r * level.cols + c] = isWall(rng) ? '#' : ' ';
+
+    // keep the part connected to a random floor cell.
+    vector<int32_t> floor;
+    for (int32_t c = 0; c < static_cast<int32_t>(level.cells.size()); c++)
+        if (level.IsFloor(c))
+            floor.push_back(c);
+    if (floor.empty())
+        return false;
+    vector<uint8_t> seen;
+    auto room = Flood(level, floor[rng() % floor.size()], false, seen);
+    if (static_cast<int32_t>(room.size()) < 3 * options.numBoxes + 2)
+        return false;
+    for (auto c : floor)
+        if (!seen[c])
+            level.cells[c] = '#';
+
+    shuffle(room.begin(), room.end(), rng);
+    for (int32_t b = 0; b < options.numBoxes; b++)
+        level.cells[room[b]] = '*';
+    level.player = room[options.numBoxes];
+    return true;
+}
+
+// Play pushes backwards: the player steps away from a box, dragging it along.
+static void Pull(Candidate& level, int32_t numPulls, mt19937_64& rng) {
+    struct Move { int32_t box, dir; };
+    vector<uint8_t> reach;
+    vector<Move> moves;
+    for (int32_t i = 0; i < numPulls; i++) {
+        Flood(level, level.player, true, reach);
+        moves.clear();
+        for (int32_t box = 0; box < static_cast<int32_t>(level.cells.size()); box++) {
+            if (!level.IsBox(box))
+                continue;
+            for (int32_t d = 0; d < NUM_DIRS; d++) {
+                auto stand = box + level.delta[d];
+                if (reach[stand] && level.IsFree(stand + level.delta[d]))
+                    moves.push_back({box, d});
+            }
+        }
+        if (moves.empty())
+            return;
+        auto m = moves[rng() % moves.size()];
+        auto d = level.delta[m.dir];
+        level.MoveBox(m.box, m.box + d);
+        level.player = m.box + 2 * d;
+    }
+}
+
+bool GradeLevel(const Sokoban& game, int64_t maxNodes, Grade& grade) {
+    GameSolver::Options options;
+    options.maxNodes  = maxNodes;
+    options.useMacros = false;  // optimal pushes.
+    auto result = GameSolver::Solve(game, options);
+    if (!result.solved)
+        return false;
+
+    const auto& a = game.GetAnalysis();
+    int32_t floor = 0, dead = 0;
+    for (int32_t c = 0; c < a.NumCells(); c++) {
+        floor += a.floor[c];
+        dead  += a.floor[c] && a.dead[c];
+    }
+    grade.pushes      = result.pushes;
+    grade.nodes       = result.nodesExpanded;
+    grade.deadDensity = floor ? static_cast<double>(dead) / floor : 0;
+    grade.score       = grade.pushes + 10 * log2(1.0 + grade.nodes) + 20 * grade.deadDensity;
+    return true;
+}
+
+int Generate(ostream& out, const Options& options) {
+    int numThreads = options.numThreads > 0 ? options.numThreads
+                                            : max(1, static_cast<int>(thread::hardware_concurrency()));
+    if (options.rows < 3 || options.cols < 3 || options.numBoxes < 1)
+        return 0;
+
+    atomic<int32_t> accepted {0};
+    atomic<int64_t> tried    {0};
+    std::mutex      outMutex;  // guards out.
+    auto Worker = [&](int id) {
+        mt19937_64 rng(options.seed + id);
+        Sokoban game;
+        while (accepted.load(memory_order_relaxed) < options.count) {
+            if (tried++ >= options.maxCandidates)
+                return;
+            Candidate level(options.rows, options.cols);
+            if (!MakeRoom(level, options, rng))
+                continue;
+            Pull(level, options.numPulls, rng);
+            if (count(level.cells.begin(), level.cells.end(), '*') == options.numBoxes)
+                continue;
+
+            Grade grade;
+            auto  candidate = level.ToLevel("");
+            game.LoadLevel(candidate);
+            if (!GradeLevel(game, options.maxNodes, grade) || grade.score < options.minScore)
+                continue;
+
+            lock_guard<std::mutex> lock(outMutex);
+            auto n = accepted + 1;
+            if (n > options.count)
+                return;
+            out << "Generated " << n << " (score " << lround(grade.score) << ", " << grade.pushes << " pushes, "
+                << grade.nodes << " nodes)" << '\n';
+            for (auto& line : candidate.lines)
+                out << line << '\n';
+            out << '\n';
+            accepted = n;
+        }
+    };
+    vector<thread> threads;
+    for (int i = 1; i < numThreads; i++)
+        threads.emplace_back(Worker, i);
+    Worker(0);
+    for (auto& t : threads)
+        t.join();
+    out.flush();
+    auto triedAll = min(tried.load(), options.maxCandidates);
+    cout << "generated " << accepted << " of " << options.count << " levels out of " << triedAll << " candidates";
+    if (accepted < options.count)
+        cout << ", gave up " << options.count - accepted << " short";
+    cout << endl;
+    return accepted;
+}
+
+int GenerateAll(const char* levelFile, const Options& options) {
+    ofstream fout(levelFile);
+    if (!fout) {
+        cout << "cannot write " << levelFile << endl;
+        return 0;
+    }
+    return Generate(fout, options);
+}
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "game.hpp"
+
+#include <iosfwd>
+#include <string>
+#include <cstdint>
+
+// Random levels, graded by how hard the solver finds them.
+//
+// A candidate starts as a random closed room with every box on a target.
+// Random pulls (pushes played backwards) then drag the boxes out, so every
+// candidate is solvable by construction. The solver grades it, and it is kept
+// when it is hard enough. Candidates are independent, so every thread makes
+// its own until enough are kept, or until maxCandidates were tried: a score
+// out of reach for the size and boxes asked for must not spin forever.
+namespace GameGenerator {
+
+struct Options {
+    int32_t  rows          = 9;        // walls included.
+    int32_t  cols          = 9;
+    int32_t  numBoxes      = 4;
+    double   wallDensity   = 0.2;      // chance of an inner cell to be a wall.
+    int32_t  numPulls      = 100;      // per candidate.
+    int32_t  count         = 10;       // levels to keep.
+    double   minScore      = 100.0;     // keep levels scoring at least this much.
+    int64_t  maxNodes      = 100'000;  // solver budget, candidates over it are dropped.
+    int64_t  maxCandidates = 100'000;  // give up after trying this many, with fewer than count kept.
+    int      numThreads    = 0;        // 0: one per core.
+    uint64_t seed          = 1;
+};
+
+struct Grade {
+    int32_t pushes      = 0;  // of an optimal solution.
+    int64_t nodes       = 0;  // expanded by the solver to find it.
+    double  deadDensity = 0;  // share of the floor a box must never enter.
+    // pushes, plus 10 per doubling of the search, plus up to 20 for dead squares.
+    double  score       = 0;
+};
+
+// Solve the current level of `game`. Return false if it is beyond `maxNodes`.
+bool GradeLevel(const Sokoban& game, int64_t maxNodes, Grade& grade);
+
+// Make `options.count` levels and write them to `out`, in the format LoadLevels
+// reads, in the order they are accepted. Return the number of levels written:
+// less than `options.count` when maxCandidates ran out first.
+int Generate(std::ostream& out, const Options& options = {});
+
+// Same, into a file.
+int GenerateAll(const char* levelFile, const Options& options = {});
+
+}
@@ -4,18 +4,43 @@
 #include "raygui.h"
 #include "raylib.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 
 using namespace std;
 
 unordered_map<uint8_t, raylib::Texture>*              g_textures;
 unordered_map<uint8_t, std::vector<raylib::Texture*>> g_pngs;
+HintEngine*                                           g_hints;
 
 namespace GameGui {
 
 static GameScene scene = START_SCENE;
 
-static GameScene GetGameScene() {
+// Hint mode is toggled by the player, and re-requested whenever the game moves on.
+static bool     hintEnabled = false;
+static uint32_t hintVersion = 0;
+static auto     hintDrawn   = HintEngine::HINT_PENDING;  // status of the hint on screen.
+
+// Keep drawing a little while after the last change, e.g., for a scene switch
+// requested from within Draw to show up.
+static constexpr double REDRAW_FOR  = 0.25; // seconds
+static double           invalidated = 0;
+
+// The key CookInputEvent() took off raylib's queue this frame, for HasInput().
+static int cookedKey = KEY_NULL;
+
+// Camera over the level, whose world units are pixels of unscaled tiles.
+// It follows the player, unless dragged away (middle button) since their last move.
+static constexpr float MIN_ZOOM   = 0.125f; // bounds the tiles on screen, whatever the level size.
+static constexpr float MAX_ZOOM   = 2.0f;
+static Camera2D        camera     {{0, 0}, {0, 0}, 0, 1};
+static float           zoom       = 1;      // as asked for, FollowPlayer clamps it.
+static Vector2         pan        {0, 0};
+static uint32_t        panVersion = 0;
+
+GameScene GetGameScene() {
     return scene;
 }
 void SetGameScene(GameScene newScene, const Sokoban& game) {
@@ -36,28 +61,67 @@ void SetGameScene(GameScene newScene, const Sokoban& game) {
     }
 }
 
+// Tiles are laid out BLOCK_PIXELS apart (at zoom 1), but their textures only
+// have as many texels as they take pixels on screen: the 128 px set when
+// zoomed in, the 64 px one, or that one scaled down when zoomed out.
+// Mipmaps and trilinear filtering take care of the sizes in between.
+#if defined(PLATFORM_WEB)
+static constexpr int BLOCK_PIXELS = 64;
+#else
+static constexpr int BLOCK_PIXELS = 128;
+#endif
+static constexpr int MIN_TEXELS   = 16;
+static int           tileTexels   = 0;  // of the textures loaded.
+
+static void LoadTiles(int texels) {
+    static const std::pair<uint8_t, const char*> files[] = {
+        {TILE_NULL         , "/Ground/ground_03.png"          },
+        {TILE_WALL         , "/Blocks/block_08.png"           },
+        {TILE_SPACE        , "/Ground/ground_04.png"          },
+        {TILE_TARGET       , "/Environment/environment_12.png"},
+        {TILE_BOX          , "/Crates/crate_42.png"           },
+        {TILE_BOX_ON_TARGET, "/Crates/crate_45.png"           },
+        {TILE_PLAYER_N     , "/Player/player_06.png"          },
+        {TILE_PLAYER_E     , "/Player/player_20.png"          },
+        {TILE_PLAYER_S     , "/Player/player_03.png"          },
+        {TILE_PLAYER_W     , "/Player/player_17.png"          },
+    };
+    std::string prefix = texels > 64 ? "assets/kenney_sokoban-pack/PNG/Retina"
+                                     : "assets/kenney_sokoban-pack/PNG/Default size";
+    auto& g_basePng = *g_textures;
+    for (auto [tile, file] : files) {
+        raylib::Image image(prefix + file);
+        if (image.GetWidth() != texels)
+            image.Resize(texels, texels);
+        // reassigned in place: g_pngs keeps pointing at the right textures.
+        g_basePng[tile] = raylib::Texture(image);
+        g_basePng[tile].GenMipmaps();
+        g_basePng[tile].SetFilter(TEXTURE_FILTER_TRILINEAR);
+    }
+    tileTexels = texels;
+}
+
+// Reload the tiles when their size on screen crosses a power of two. Going
+// down waits until well below it, so zooming around a threshold doesn't
+// reload every frame.
+static void FitTiles(float pixels) {
+    int texels = MIN_TEXELS;
+    while (texels < pixels && texels < BLOCK_PIXELS)
+        texels *= 2;
+    if (texels < tileTexels && pixels > tileTexels / 2 * 0.8f)
+        return;
+    if (texels != tileTexels)
+        LoadTiles(texels);
+}
+
 void Init(GameResources* resourcePtr) {
     // g_basePng used to be a global static variable.
     // But I've see segfault in glDeleteTextures if it is destructed too late.
     // So, let's just keep a reference in main, so it's destructed timely.
     g_textures = &resourcePtr->textures;
+    g_hints    = &resourcePtr->hints;
     auto& g_basePng = *g_textures;
-#if defined(PLATFORM_WEB)
-    std::string prefix = "assets/kenney_sokoban-pack/PNG/Default size";
-#else
-    std::string prefix = "assets/kenney_sokoban-pack/PNG/Retina";
-#endif
-
-    g_basePng[TILE_NULL            ] = raylib::Texture(prefix + "/Ground/ground_03.png");
-    g_basePng[TILE_WALL            ] = raylib::Texture(prefix + "/Blocks/block_08.png");
-    g_basePng[TILE_SPACE           ] = raylib::Texture(prefix + "/Ground/ground_04.png");
-    g_basePng[TILE_TARGET          ] = raylib::Texture(prefix + "/Environment/environment_12.png");
-    g_basePng[TILE_BOX             ] = raylib::Texture(prefix + "/Crates/crate_42.png");
-    g_basePng[TILE_BOX_ON_TARGET   ] = raylib::Texture(prefix + "/Crates/crate_45.png");
-    g_basePng[TILE_PLAYER_N        ] = raylib::Texture(prefix + "/Player/player_06.png");
-    g_basePng[TILE_PLAYER_E        ] = raylib::Texture(prefix + "/Player/player_20.png");
-    g_basePng[TILE_PLAYER_S        ] = raylib::Texture(prefix + "/Player/player_03.png");
-    g_basePng[TILE_PLAYER_W        ] = raylib::Texture(prefix + "/Player/player_17.png");
+    LoadTiles(BLOCK_PIXELS);
 
     g_pngs[TILE_NULL               ] = {&g_basePng[TILE_NULL]};
     g_pngs[TILE_WALL               ] = {&g_basePng[TILE_NULL], &g_basePng[TILE_WALL]};
@@ -73,44 +137,117 @@ void Init(GameResources* resourcePtr) {
     g_pngs[TILE_PLAYER_E_ON_TARGET ] = {&g_basePng[TILE_SPACE], &g_basePng[TILE_PLAYER_E]};
     g_pngs[TILE_PLAYER_S_ON_TARGET ] = {&g_basePng[TILE_SPACE], &g_basePng[TILE_PLAYER_S]};
     g_pngs[TILE_PLAYER_W_ON_TARGET ] = {&g_basePng[TILE_SPACE], &g_basePng[TILE_PLAYER_W]};
+    Invalidate();
 }
 
+// Only the tiles in view, so big levels draw as fast as small ones.
 static void DrawGameScene(const Sokoban::State& state) {
-    auto& g_basePng = *g_textures;
-    const int blockPixels = g_basePng[TILE_NULL].GetWidth();
-    for (int i=0; i<state.size(); i++) {
-        for (int j=0; j<state[i].size(); j++) {
+    const int   blockPixels = BLOCK_PIXELS;
+    const float scale       = static_cast<float>(blockPixels) / tileTexels;
+    auto topLeft     = GetScreenToWorld2D({0, 0}, camera);
+    auto bottomRight = GetScreenToWorld2D({static_cast<float>(GetScreenWidth()), static_cast<float>(GetScreenHeight())}, camera);
+    int  rowBegin    = max(0, static_cast<int>(floorf(topLeft.y / blockPixels)));
+    int  colBegin    = max(0, static_cast<int>(floorf(topLeft.x / blockPixels)));
+    int  rowEnd      = min(static_cast<int>(state.size()),    static_cast<int>(ceilf(bottomRight.y / blockPixels)));
+    int  colEnd      = min(static_cast<int>(state[0].size()), static_cast<int>(ceilf(bottomRight.x / blockPixels)));
+    for (int i=rowBegin; i<rowEnd; i++) {
+        for (int j=colBegin; j<colEnd; j++) {
             auto c = state[i][j];
             for (auto png:g_pngs[c]) {
-                png->Draw(j*blockPixels, i*blockPixels);
+                png->Draw(Vector2{static_cast<float>(j*blockPixels), static_cast<float>(i*blockPixels)}, 0, scale);
             }
         }
     }
 }
 
+// Outline the box to push and point where it goes, in level coordinates.
+// The search runs on another thread, if it's not done yet just draw nothing.
+// Return false if there is no hint to give.
+static bool DrawHint(const Sokoban& game, int blockPixels) {
+    if (game.GetVersion() != hintVersion) {
+        hintVersion = game.GetVersion();
+        g_hints->Request(game);
+    }
+    g_hints->Update();
+    auto hint = g_hints->Poll();
+    hintDrawn = hint.status;
+    switch (hint.status) {
+    case HintEngine::HINT_PENDING: break;
+    case HintEngine::HINT_NONE: {
+        return false;
+    } break;
+    case HintEngine::HINT_FOUND: {
+        float     size   = static_cast<float>(blockPixels);
+        Rectangle rect   {hint.box.col * size, hint.box.row * size, size, size};
+        Vector2   center {rect.x + size / 2, rect.y + size / 2};
+        Vector2   tip    {center.x + DIR_POS[hint.dir].col * size * 0.75f,
+                          center.y + DIR_POS[hint.dir].row * size * 0.75f};
+        DrawRectangleLinesEx(rect, size / 16, ORANGE);
+        DrawLineEx(center, tip, size / 12, ORANGE);
+        DrawCircleV(tip, size / 8, ORANGE);
+    } break;
+    }
+    return true;
+}
+
 static int GetBlockPixels() {
-    auto& g_basePng = *g_textures;
-    assert(g_basePng.at(TILE_NULL).GetWidth() == g_basePng.at(TILE_NULL).GetHeight());
-    return g_basePng.at(TILE_NULL).GetWidth();
+    return BLOCK_PIXELS;
 }
 
+// The level at full size, unless that doesn't fit the monitor: the camera shows the rest.
 std::pair<int,int> GetWindowSize(const Sokoban::State& state) {
-    return {static_cast<int>(state[0].size()) * GetBlockPixels(),
-            static_cast<int>(state.size())    * GetBlockPixels()};
+    int width   = static_cast<int>(state[0].size()) * GetBlockPixels();
+    int height  = static_cast<int>(state.size())    * GetBlockPixels();
+    int monitor = GetCurrentMonitor();
+    if (int maxWidth  = GetMonitorWidth (monitor) * 9 / 10; maxWidth  > 0) width  = min(width,  maxWidth);
+    if (int maxHeight = GetMonitorHeight(monitor) * 9 / 10; maxHeight > 0) height = min(height, maxHeight);
+    return {width, height};
+}
+
+static void FollowPlayer(const Sokoban& game) {
+    const float size   = static_cast<float>(GetBlockPixels());
+    const float levelW = game.GetState()[0].size() * size;
+    const float levelH = game.GetState().size()    * size;
+    const float viewW  = static_cast<float>(GetScreenWidth());
+    const float viewH  = static_cast<float>(GetScreenHeight());
+    // zoom out no further than the whole level, and never below full size for small ones.
+    zoom = clamp(zoom, max(MIN_ZOOM, min({viewW / levelW, viewH / levelH, 1.0f})), MAX_ZOOM);
+
+    if (game.GetVersion() != panVersion) {
+        panVersion = game.GetVersion();
+        pan        = {0, 0};
+    }
+    if (IsMouseButtonDown(MOUSE_BUTTON_MIDDLE)) {
+        auto delta = GetMouseDelta();
+        pan.x -= delta.x / zoom;
+        pan.y -= delta.y / zoom;
+    }
+    // center on the player, but don't show past the level edges when it's bigger than the view.
+    auto Fit = [](float center, float level, float view) {
+        return level <= view ? level / 2 : clamp(center, view / 2, level - view / 2);
+    };
+    auto    player = game.GetPlayerPos();
+    Vector2 follow {(player.col + 0.5f) * size, (player.row + 0.5f) * size};
+    camera.zoom   = zoom;
+    camera.offset = {viewW / 2, viewH / 2};
+    camera.target = {Fit(follow.x + pan.x, levelW, viewW / zoom), Fit(follow.y + pan.y, levelH, viewH / zoom)};
+    pan           = {camera.target.x - follow.x, camera.target.y - follow.y};
 }
 
 Sokoban::Pos PixelToPos(Vector2 pos) {
-    int nrow = static_cast<int>(pos.y) / GetBlockPixels();
-    int ncol = static_cast<int>(pos.x) / GetBlockPixels();
+    auto world = GetScreenToWorld2D(pos, camera);
+    int  nrow  = static_cast<int>(floorf(world.y / GetBlockPixels()));
+    int  ncol  = static_cast<int>(floorf(world.x / GetBlockPixels()));
     return {nrow, ncol};
 }
 
-pair<vector<GameEvent>, GuiEvent> CookInputEvent(const Sokoban& game) {
+GuiEvent CookInputEvent(const Sokoban& game, GameEventQueue& gameEvents, double polledAt) {
     static int lastKeyPressed = KEY_NULL;
+    cookedKey = KEY_NULL;
     bool leftButton  = IsMouseButtonPressed(MOUSE_LEFT_BUTTON) ||
                        IsMouseButtonDown(MOUSE_LEFT_BUTTON);
     bool rightButton = IsMouseButtonReleased(MOUSE_RIGHT_BUTTON);
-    std::vector<GameEvent> gameEvents;
+    float wheel      = GetMouseWheelMove();
     GuiEvent guiEvent = GuiEvent::EVENT_NULL;
 
     if (IsKeyPressed(KEY_ESCAPE)) {
@@ -118,32 +255,47 @@ pair<vector<GameEvent>, GuiEvent> CookInputEvent(const Sokoban& game) {
     }
 
     if (GetGameScene() != MAIN_GAME_SCENE) {
-        return {{}, guiEvent};
+        return guiEvent;
     }
 
     if (game.LevelCompleted()) {
-        return {{}, GuiEvent::EVENT_MENU_LEVEL_FINISHED};
+        return GuiEvent::EVENT_MENU_LEVEL_FINISHED;
     }
 
     // TODO: add option for keyboard layout / AWERTY?
     if (auto key = GetKeyPressed())
-        lastKeyPressed = key;
+        lastKeyPressed = cookedKey = key;
+
+    if (wheel != 0)
+        guiEvent = wheel > 0 ? GuiEvent::EVENT_ZOOM_IN : GuiEvent::EVENT_ZOOM_OUT;
 
+    auto Add = [&gameEvents, polledAt](GameEvent e) { gameEvents.Push({e, 0, 0, polledAt}); };
     if (leftButton) {
-        gameEvents.push_back(GameEvent::EVENT_MOVE_CLICK);
+        auto pos = PixelToPos(GetMousePosition());
+        gameEvents.Push({GameEvent::EVENT_MOVE_CLICK, pos.row, pos.col, polledAt});
     }
     if (rightButton) {
-        gameEvents.push_back(GameEvent::EVENT_MOVE_REGRET);
+        Add(GameEvent::EVENT_MOVE_REGRET);
     } else if (IsKeyPressed(lastKeyPressed) || IsKeyPressedRepeat(lastKeyPressed)) {
         auto key = lastKeyPressed;
-        if (GameConfig::IsUp     (key)) { gameEvents.push_back(GameEvent::EVENT_MOVE_UP);     }
-        if (GameConfig::IsDown   (key)) { gameEvents.push_back(GameEvent::EVENT_MOVE_DOWN);   }
-        if (GameConfig::IsRight  (key)) { gameEvents.push_back(GameEvent::EVENT_MOVE_RIGHT);  }
-        if (GameConfig::IsLeft   (key)) { gameEvents.push_back(GameEvent::EVENT_MOVE_LEFT);   }
-        if (GameConfig::IsRestart(key)) { gameEvents.push_back(GameEvent::EVENT_MOVE_RESTART);}
-        if (GameConfig::IsRegret (key)) { gameEvents.push_back(GameEvent::EVENT_MOVE_REGRET); }
+        if (GameConfig::IsUp     (key)) { Add(GameEvent::EVENT_MOVE_UP);     }
+        if (GameConfig::IsDown   (key)) { Add(GameEvent::EVENT_MOVE_DOWN);   }
+        if (GameConfig::IsRight  (key)) { Add(GameEvent::EVENT_MOVE_RIGHT);  }
+        if (GameConfig::IsLeft   (key)) { Add(GameEvent::EVENT_MOVE_LEFT);   }
+        if (GameConfig::IsRestart(key)) { Add(GameEvent::EVENT_MOVE_RESTART);}
+        if (GameConfig::IsRegret (key)) { Add(GameEvent::EVENT_MOVE_REGRET); }
+        if (GameConfig::IsHint   (key) && IsKeyPressed(key)) { guiEvent = GuiEvent::EVENT_HINT; }
+        if (GameConfig::IsZoomIn (key)) { guiEvent = GuiEvent::EVENT_ZOOM_IN;  }
+        if (GameConfig::IsZoomOut(key)) { guiEvent = GuiEvent::EVENT_ZOOM_OUT; }
     }
-    return {gameEvents,guiEvent};
+    return guiEvent;
+}
+
+void DrawLatency(const LatencyMeter& meter) {
+    auto s = meter.Summarize();
+    DrawText(TextFormat("input latency p50 %.1f p95 %.1f max %.1f ms (%d)",
+                        s.p50 * 1000, s.p95 * 1000, s.max * 1000, static_cast<int>(s.count)),
+             10, GetScreenHeight() - 30, 20, DARKGREEN);
 }
 
 // TODO: prototyping.
@@ -213,16 +365,64 @@ GuiEvent Draw(raylib::Window& window, const Sokoban& game) {
                 ret = button.event;
     } break;
     case MAIN_GAME_SCENE: {
+        FollowPlayer(game);
+        FitTiles(GetBlockPixels() * camera.zoom);
+        BeginMode2D(camera);
         DrawGameScene(game.GetState());
+        bool hasHint = !hintEnabled || DrawHint(game, GetBlockPixels());
+        EndMode2D();
+        if (!hasHint)
+            DrawText("no hint", 10, 10, 40, RED);
     } break;
     // It's OK to omit default because -Wswitch-enum is enabled
     }
     return ret;
 }
 
+void Invalidate() {
+    invalidated = GetTime();
+}
+
+static bool HasInput() {
+    if (IsWindowResized() || GetTouchPointCount() > 0 || GetMouseWheelMove() != 0)
+        return true;
+    auto delta = GetMouseDelta();
+    if (delta.x != 0 || delta.y != 0)
+        return true;
+    for (int button = MOUSE_BUTTON_LEFT; button <= MOUSE_BUTTON_BACK; button++)
+        if (IsMouseButtonDown(button) || IsMouseButtonReleased(button))
+            return true;
+    // the queues are emptied by every poll, so what's left here is this frame's only.
+    return cookedKey != KEY_NULL || GetKeyPressed() != KEY_NULL || GetCharPressed() != 0;
+}
+
+bool ShouldDraw() {
+    if (HasInput())
+        Invalidate();
+    // a hint coming in shows up without any input. While it's in the making,
+    // WaitForInput() sleeps on, a frame at a time, until the answer is there.
+    if (GetGameScene() == MAIN_GAME_SCENE && hintEnabled && g_hints->Poll().status != hintDrawn)
+        Invalidate();
+#if defined(PLATFORM_WEB)
+    // there, the search runs a slice per drawn frame (see DrawHint): keep drawing until it's done.
+    if (GetGameScene() == MAIN_GAME_SCENE && hintEnabled && hintDrawn == HintEngine::HINT_PENDING)
+        Invalidate();
+#endif
+    return GetTime() - invalidated < REDRAW_FOR;
+}
+
+void WaitForInput() {
+    // bounded, so the loop sees what changes without input, like a hint coming
+    // in, without waking up from another thread. On web, blocking would freeze the page.
+    WaitTime(1.0 / 60);
+    PollInputEvents();
+}
+
 // Return true if we should exit
 bool ProcessGuiEvent(GuiEvent e, Sokoban& game) {
     bool shouldExit = false;
+    if (e != GuiEvent::EVENT_NULL)
+        Invalidate();
     switch (e) {
     case GuiEvent::EVENT_MENU_START: {
         SetGameScene(MAIN_GAME_SCENE, game);
@@ -258,8 +458,22 @@ bool ProcessGuiEvent(GuiEvent e, Sokoban& game) {
     case GuiEvent::EVENT_MENU_NEXT_LEVEL: {
         assert(!game.IsLastLevel());
         game.NextLevel();
+        g_hints->Cancel();
+        hintVersion = game.GetVersion() - 1; // request on next Draw, if enabled.
         SetGameScene(MAIN_GAME_SCENE, game);
     } break;
+    case GuiEvent::EVENT_HINT: {
+        hintEnabled = !hintEnabled;
+        if (!hintEnabled)
+            g_hints->Cancel();
+        hintVersion = game.GetVersion() - 1; // request on next Draw.
+    } break;
+    case GuiEvent::EVENT_ZOOM_IN: {
+        zoom *= 1.25f;
+    } break;
+    case GuiEvent::EVENT_ZOOM_OUT: {
+        zoom /= 1.25f;
+    } break;
     case GuiEvent::EVENT_NULL:
         break;
     }
@@ -1,6 +1,8 @@
 #pragma once
 #include "game.hpp"
 #include "game_event.hpp"
+#include "game_hint.hpp"
+#include "game_latency.hpp"
 #include "raylib.h"
 #include "raylib-cpp.hpp"
 
@@ -18,16 +20,28 @@ enum GameScene : uint8_t {
 
 struct GameResources {
     std::unordered_map<uint8_t, raylib::Texture> textures;
+    HintEngine                                   hints;
 };
 
 void Init(GameResources* resourcePtr);
+GameScene GetGameScene();
+void SetGameScene(GameScene newScene, const Sokoban& game);
 
-// CookInputEvent just translates kbd/mouse event into GameEvent
-std::pair<std::vector<GameEvent>, GuiEvent> CookInputEvent(const Sokoban& game);
+// CookInputEvent just translates kbd/mouse event into GameEvent, appended to `events`,
+// stamped `polledAt`: the GetTime() right after the PollInputEvents() that read them.
+GuiEvent CookInputEvent(const Sokoban& game, GameEventQueue& events, double polledAt);
 
 // GuiEvent here means raygui interaction, e.g., button clicked.
 GuiEvent Draw(raylib::Window& window, const Sokoban& game);
 bool ProcessGuiEvent(GuiEvent guiEvent, Sokoban& game);
+void DrawLatency(const LatencyMeter& meter);
+
+// Idle mode: frames are only drawn when something may look different.
+// Anything that changes what's on screen without input calls Invalidate().
+void Invalidate();
+bool ShouldDraw();
+// Sleep for about a frame, then poll input.
+void WaitForInput();
 std::pair<int,int> GetWindowSize(const Sokoban::State& state);
 Sokoban::Pos PixelToPos(Vector2 pos);
 
@@ -0,0 +1,124 @@
+#include "game_hint.hpp"
+#include "game_solver.hpp"
+
+#include <cctype>
+#include <cstring>
+
+using namespace std;
+
+static uint64_t Pack(uint32_t generation, HintEngine::Hint hint) {
+    return (static_cast<uint64_t>(generation) << 32) |
+           (static_cast<uint64_t>(hint.status) << 30) |
+           (static_cast<uint64_t>(hint.dir)    << 28) |
+           (static_cast<uint64_t>(hint.box.row & 0x3fff) << 14) |
+           (static_cast<uint64_t>(hint.box.col & 0x3fff));
+}
+
+HintEngine::HintEngine() {
+#if !defined(PLATFORM_WEB)
+    worker = thread(&HintEngine::Run, this);
+#endif
+}
+
+HintEngine::~HintEngine() {
+    if (!worker.joinable())
+        return;
+    {
+        lock_guard<std::mutex> lock(mutex);
+        quit = true;
+        cancel = true;
+    }
+    wakeUp.notify_one();
+    worker.join();
+}
+
+void HintEngine::Request(const Sokoban& game) {
+#if defined(PLATFORM_WEB)
+    GameSolver::Options options;
+    options.maxNodes  = 200'000;  // a few hundred frames at most.
+    options.useMacros = true;     // any solution will do.
+    search.emplace(game, options);
+    searchFrom = game.GetPlayerPos();
+    generation++;
+#else
+    {
+        lock_guard<std::mutex> lock(mutex);
+        pending = game.Snapshot();
+        generation++;
+        cancel = true;
+    }
+    wakeUp.notify_one();
+#endif
+}
+
+void HintEngine::Cancel() {
+#if defined(PLATFORM_WEB)
+    search.reset();
+    generation++;
+#else
+    lock_guard<std::mutex> lock(mutex);
+    pending.reset();
+    generation++;
+    cancel = true;
+#endif
+}
+
+HintEngine::Hint HintEngine::Poll() const {
+    auto packed = mailbox.load(memory_order_acquire);
+    if (static_cast<uint32_t>(packed >> 32) != generation.load(memory_order_acquire))
+        return {HINT_PENDING, {0, 0}, DIR_LEFT};
+    return {static_cast<Status>((packed >> 30) & 3),
+            {static_cast<int>((packed >> 14) & 0x3fff), static_cast<int>(packed & 0x3fff)},
+            static_cast<Dir>((packed >> 28) & 3)};
+}
+
+void HintEngine::Update() {
+#if defined(PLATFORM_WEB)
+    if (search && search->Step(NODES_PER_UPDATE)) {
+        Publish(searchFrom, search->GetResult(), generation);
+        search.reset();
+    }
+#endif
+}
+
+void HintEngine::Solve(const Sokoban& snapshot, uint32_t forGeneration) {
+    GameSolver::Options options;
+    options.cancel    = &cancel;
+    options.maxNodes  = 1'000'000;
+    options.useMacros = true;  // any solution will do.
+    auto result = GameSolver::Solve(snapshot, options);
+    if (cancel.load(memory_order_relaxed))
+        return;
+    Publish(snapshot.GetPlayerPos(), result, forGeneration);
+}
+
+void HintEngine::Publish(Sokoban::Pos player, const GameSolver::Result& result, uint32_t forGeneration) {
+    Hint hint {HINT_NONE, {0, 0}, DIR_LEFT};
+    for (auto c : result.lurd) {
+        auto d = static_cast<Dir>(strchr(LURD, tolower(c)) - LURD);
+        if (isupper(c)) {
+            hint = {HINT_FOUND, player + DIR_POS[d], d};
+            break;
+        }
+        player = player + DIR_POS[d];
+    }
+    mailbox.store(Pack(forGeneration, hint), memory_order_release);
+}
+
+void HintEngine::Run() {
+    while (true) {
+        Sokoban  snapshot;
+        uint32_t forGeneration;
+        {
+            unique_lock<std::mutex> lock(mutex);
+            wakeUp.wait(lock, [this] { return quit || pending.has_value(); });
+            if (quit)
+                return;
+            snapshot      = std::move(*pending);
+            forGeneration = generation;
+            pending.reset();
+            cancel = false;
+        }
+        Solve(snapshot, forGeneration);
+    }
+}
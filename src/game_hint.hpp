@@ -0,0 +1,68 @@
+#pragma once
+
+#include "game.hpp"
+#include "game_analysis.hpp"
+#include "game_solver.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <cstdint>
+
+// Looks for the next push in the background, so the frame loop never waits on the solver.
+//
+// Request() hands a snapshot to the worker and cancels whatever it was doing.
+// Cancel() just stops it, when no hint is wanted anymore.
+// The worker publishes its answer into a single lock-free slot tagged with
+// the request's generation, so Poll() never returns a hint for an old state.
+//
+// The web build has no threads: there, Update() runs a slice of the search per frame.
+class HintEngine {
+public:
+    enum Status : uint8_t {
+        HINT_PENDING,
+        HINT_FOUND,
+        HINT_NONE,    // unsolvable from here, or too hard to tell.
+    };
+    struct Hint {
+        Status       status;
+        Sokoban::Pos box;  // push this box,
+        Dir          dir;  // in this direction.
+    };
+
+    HintEngine();
+    ~HintEngine();
+    HintEngine(const HintEngine&) = delete;
+    HintEngine& operator=(const HintEngine&) = delete;
+
+    void Request(const Sokoban& game);
+    // Drop the search in flight, if any. Poll() stays HINT_PENDING until the next Request().
+    void Cancel();
+    Hint Poll() const;
+    // Web: search on for NODES_PER_UPDATE nodes, once a frame. No-op elsewhere.
+    void Update();
+
+private:
+    void Publish(Sokoban::Pos player, const GameSolver::Result& result, uint32_t generation);
+    void Solve(const Sokoban& snapshot, uint32_t generation);
+    void Run();
+
+#if defined(PLATFORM_WEB)
+    static constexpr int64_t NODES_PER_UPDATE = 1'000;  // a few ms of the frame.
+    std::optional<GameSolver::Incremental> search;
+    Sokoban::Pos                           searchFrom {0, 0};
+#endif
+
+    // [63..32] generation, [31..30] status, [29..28] dir, [27..14] row, [13..0] col
+    std::atomic<uint64_t> mailbox    {0};
+    std::atomic<uint32_t> generation {0};
+    std::atomic<bool>     cancel     {false};
+
+    std::mutex              mutex;  // guards pending and quit.
+    std::condition_variable wakeUp;
+    std::optional<Sokoban>  pending;
+    bool                    quit = false;
+    std::thread             worker;
+};
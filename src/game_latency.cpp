@@ -0,0 +1,23 @@
+#include "game_latency.hpp"
+
+#include <algorithm>
+
+using namespace std;
+
+void LatencyMeter::Record(double seconds) {
+    samples[total++ % SAMPLES] = static_cast<float>(seconds);
+}
+
+LatencyMeter::Summary LatencyMeter::Summarize() const {
+    Summary summary;
+    summary.count = static_cast<size_t>(min<uint64_t>(total, SAMPLES));
+    if (summary.count == 0)
+        return summary;
+    auto sorted = samples;
+    auto end    = sorted.begin() + summary.count;
+    sort(sorted.begin(), end);
+    summary.p50 = sorted[summary.count / 2];
+    summary.p95 = sorted[summary.count * 95 / 100];
+    summary.max = *(end - 1);
+    return summary;
+}
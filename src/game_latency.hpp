@@ -0,0 +1,31 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Input-to-present latency: from raylib polling an input to the end of
+// EndDrawing() of the frame showing its effect. The OS may hold the input
+// before that poll: none after an idle wait, which wakes on it, but up to a
+// frame while drawing, since EndDrawing() polls after waiting out the frame.
+// So this is a lower bound. Only the last SAMPLES samples are kept, no
+// allocation.
+class LatencyMeter {
+public:
+    static constexpr size_t SAMPLES = 256;
+
+    struct Summary {
+        size_t count = 0;  // samples summarized.
+        double p50   = 0;  // seconds.
+        double p95   = 0;
+        double max   = 0;
+    };
+
+    void     Record(double seconds);
+    Summary  Summarize() const;
+    uint64_t Total() const { return total; }
+
+private:
+    std::array<float, SAMPLES> samples {};
+    uint64_t                   total = 0;
+};
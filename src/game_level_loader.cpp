@@ -134,8 +134,7 @@ static std::optional<Sokoban::Level> LoadOneLevel(const vector<string>& vs) {
     return {level};
 }
 
-bool Sokoban::LoadLevelFromFile(const char* levelFile) {
-    ifstream fin(levelFile);
+bool Sokoban::LoadLevelFromFile(istream& fin) {
     vector<string> vs;
     bool fileGood = true;
     while (fileGood) {
@@ -157,11 +156,18 @@ bool Sokoban::LoadLevelFromFile(const char* levelFile) {
 }
 
 bool Sokoban::LoadLevels(const char *file) {
+    ifstream fin(file);
+    return LoadLevels(fin);
+}
+
+bool Sokoban::LoadLevels(istream& in) {
     levels.clear();
-    if (!LoadLevelFromFile(file)) {
+    curLevel = 0;
+    if (!LoadLevelFromFile(in)) {
         LoadDefaultLevels();
         return false;
     } else {
+        ResetPack();
         LoadLevel(levels[curLevel]);
     }
     return true;
@@ -0,0 +1,179 @@
+#include "game_optimizer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <thread>
+
+#include <cctype>
+
+using namespace std;
+
+namespace GameOptimizer {
+
+// Apply one LURD move. Return false if the player didn't go anywhere.
+static bool Move(Sokoban& game, char c) {
+    auto pos = game.GetPlayerPos();
+    switch (tolower(c)) {
+    case 'l': game.PushWest();  break;
+    case 'u': game.PushNorth(); break;
+    case 'r': game.PushEast();  break;
+    case 'd': game.PushSouth(); break;
+    default: return false;
+    }
+    return !(game.GetPlayerPos() == pos);
+}
+
+// Replay `lurd` and cut it into one segment per push. Moves that don't go
+// anywhere are dropped, and so is any walk after the last push. Letters are
+// re-cased, since player submitted solutions don't always mark pushes.
+// Return whether the level ends up solved.
+static bool Split(const Sokoban& from, const string& lurd, vector<string>& segments) {
+    auto game = from.Snapshot();
+    segments.clear();
+    string segment;
+    for (auto c : lurd) {
+        auto pushes = game.GetNumPushes();
+        if (!Move(game, c))
+            continue;
+        bool pushed = game.GetNumPushes() != pushes;
+        segment += static_cast<char>(pushed ? toupper(c) : tolower(c));
+        if (pushed) {
+            segments.push_back(segment);
+            segment.clear();
+        }
+    }
+    return game.LevelCompleted();
+}
+
+struct Cost {
+    int32_t moves, pushes;
+};
+
+// Compare (primary metric, the other one).
+static bool Better(Cost a, Cost b, GameSolver::Metric metric) {
+    if (metric == GameSolver::Metric::PUSHES)
+        return a.pushes != b.pushes ? a.pushes < b.pushes : a.moves < b.moves;
+    return a.moves != b.moves ? a.moves < b.moves : a.pushes < b.pushes;
+}
+
+static Cost CostOf(const vector<string>& segments, size_t begin, size_t end) {
+    Cost cost {0, static_cast<int32_t>(end - begin)};
+    for (auto i = begin; i < end; i++)
+        cost.moves += static_cast<int32_t>(segments[i].size());
+    return cost;
+}
+
+string Optimize(const Sokoban& game, const string& lurd, const Options& options) {
+    using Clock   = chrono::steady_clock;
+    auto deadline = Clock::now() + chrono::duration_cast<Clock::duration>(chrono::duration<double>(options.timeBudget));
+    int numThreads = options.numThreads > 0 ? options.numThreads
+                                            : max(1, static_cast<int>(thread::hardware_concurrency()));
+
+    vector<string> segments;
+    if (!Split(game, lurd, segments))
+        return "";
+
+    int32_t window = max(options.minWindow, 1);
+    int32_t offset = 0;
+    while (Clock::now() < deadline) {
+        const auto n = static_cast<int32_t>(segments.size());
+        // windows of this pass: [bounds[k], bounds[k+1])
+        vector<int32_t> bounds = {0};
+        for (int32_t b = offset ? offset : window; b < n; b += window)
+            bounds.push_back(b);
+        bounds.push_back(n);
+
+        // bare positions at the bounds: no level pack, no stats, no undo history.
+        vector<Sokoban> positions;
+        positions.reserve(bounds.size());
+        auto position = game.Snapshot();
+        positions.push_back(position.Snapshot());
+        for (size_t k = 1; k < bounds.size(); k++) {
+            for (auto s = bounds[k-1]; s < bounds[k]; s++)
+                for (auto c : segments[s])
+                    Move(position, c);
+            positions.push_back(position.Snapshot());
+        }
+
+        vector<string> replacements(bounds.size() - 1);
+        atomic<size_t> nextWindow {0};
+        auto Worker = [&]() {
+            for (size_t k; (k = nextWindow++) < replacements.size(); ) {
+                auto original = CostOf(segments, bounds[k], bounds[k+1]);
+                GameSolver::Options solverOptions;
+                solverOptions.metric    = options.metric;
+                solverOptions.maxNodes  = options.maxNodes;
+                solverOptions.maxCost   = options.metric == GameSolver::Metric::PUSHES ? original.pushes : original.moves;
+                solverOptions.deadline  = deadline;
+                solverOptions.useMacros = false;
+                auto result = GameSolver::SolveBetween(positions[k], positions[k+1], solverOptions);
+                if (result.solved && Better({result.moves, result.pushes}, original, options.metric))
+                    replacements[k] = result.lurd;
+            }
+        };
+        vector<thread> threads;
+        for (int i = 1; i < min(numThreads, static_cast<int>(replacements.size())); i++)
+            threads.emplace_back(Worker);
+        Worker();
+        for (auto& t : threads)
+            t.join();
+
+        bool improved = false;
+        string joined;
+        for (size_t k = 0; k < replacements.size(); k++) {
+            improved |= !replacements[k].empty();
+            if (replacements[k].size())
+                joined += replacements[k];
+            else
+                for (auto s = bounds[k]; s < bounds[k+1]; s++)
+                    joined += segments[s];
+        }
+        vector<string> next;
+        if (improved && Split(game, joined, next)) {
+            segments = std::move(next);
+            continue;
+        }
+        // nothing found: shift the windows by half, then try wider ones.
+        if (window >= n)
+            break;
+        if (offset == 0 && window > 1) {
+            offset = window / 2;
+        } else {
+            offset  = 0;
+            window *= 2;
+        }
+    }
+    return accumulate(segments.begin(), segments.end(), string());
+}
+
+int OptimizeAll(Sokoban& game, const char* solutionFile, const Options& options) {
+    ifstream fin(solutionFile);
+    int invalid = 0;
+    for (string line; getline(fin, line); ) {
+        if (line.empty())
+            continue;
+        vector<string> segments;
+        Split(game, line, segments);
+        auto before = CostOf(segments, 0, segments.size());
+        auto lurd   = Optimize(game, line, options);
+        cout << "level " << game.GetCurLevel() << " " << game.GetCurLevelName() << ": ";
+        if (lurd.empty()) {
+            cout << "invalid solution" << endl;
+            invalid++;
+        } else {
+            Split(game, lurd, segments);
+            auto after = CostOf(segments, 0, segments.size());
+            cout << before.moves << "/" << before.pushes << " -> "
+                 << after.moves  << "/" << after.pushes  << " moves/pushes, " << lurd << endl;
+        }
+        if (game.IsLastLevel())
+            break;
+        game.NextLevel();
+    }
+    return invalid;
+}
+
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "game.hpp"
+#include "game_solver.hpp"
+
+#include <string>
+#include <cstdint>
+
+// Shorten an existing solution by re-solving windows of it.
+//
+// A solution is cut into segments, one per push: the walk to the box plus the
+// push itself. Any window of consecutive segments goes from one known position
+// to another, so it can be replaced by anything cheaper between the same two
+// positions. Windows of one pass don't overlap, so they are solved in parallel.
+namespace GameOptimizer {
+
+struct Options {
+    GameSolver::Metric metric     = GameSolver::Metric::MOVES;
+    double             timeBudget = 5.0;     // seconds, for the whole solution.
+    int                numThreads = 0;       // 0: one per core.
+    int32_t            minWindow  = 4;       // pushes; doubled whenever a pass finds nothing.
+    int64_t            maxNodes   = 200'000; // per window.
+};
+
+// Return a solution for the current level of `game`, no worse than `lurd` in
+// `options.metric`, or an empty string if `lurd` doesn't solve the level.
+std::string Optimize(const Sokoban& game, const std::string& lurd, const Options& options = {});
+
+// Optimize the solutions in `solutionFile`, one line per level starting from
+// the current one. Return the number of lines that didn't solve their level.
+int OptimizeAll(Sokoban& game, const char* solutionFile, const Options& options = {});
+
+}
@@ -0,0 +1,217 @@
+#include "game_session.hpp"
+
+#include <fstream>
+#include <iterator>
+
+using namespace std;
+
+// Little-endian fields, whatever the host.
+template <typename T>
+static void Put(vector<uint8_t>& out, T value) {
+    for (size_t i = 0; i < sizeof(T); i++)
+        out.push_back(static_cast<uint8_t>(static_cast<uint64_t>(value) >> (8 * i)));
+}
+
+// Reads fields in order, turns false for good once past the end.
+struct Reader {
+    const uint8_t* data;
+    size_t         size;
+    size_t         at = 0;
+    bool           ok = true;
+
+    template <typename T>
+    T Get() {
+        if (!ok || size - at < sizeof(T)) {
+            ok = false;
+            return 0;
+        }
+        uint64_t value = 0;
+        for (size_t i = 0; i < sizeof(T); i++)
+            value |= static_cast<uint64_t>(data[at++]) << (8 * i);
+        return static_cast<T>(value);
+    }
+    const uint8_t* Skip(size_t n) {
+        if (!ok || size - at < n) {
+            ok = false;
+            return nullptr;
+        }
+        at += n;
+        return data + at - n;
+    }
+};
+
+static uint64_t Fnv1a(const uint8_t* data, size_t size, uint64_t hash = 0xcbf29ce484222325ULL) {
+    for (size_t i = 0; i < size; i++)
+        hash = (hash ^ data[i]) * 0x100000001b3ULL;
+    return hash;
+}
+
+// Tells levels apart, so a session never lands on a different level of the same index.
+static uint64_t Fingerprint(const Sokoban::Level& level) {
+    uint64_t hash = Fnv1a(nullptr, 0);
+    for (int32_t r = 0; r < level.Rows(); r++) {
+        hash = Fnv1a(reinterpret_cast<const uint8_t*>(level.Row(r)), level.Cols(), hash);
+        hash = Fnv1a(reinterpret_cast<const uint8_t*>("\n"), 1, hash);
+    }
+    return hash;
+}
+
+static constexpr Sokoban::Pos JOURNAL_DP[4] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+
+// u32 level, u64 fingerprint, u16 rows, u16 cols, u32 player cell, u8 player facing,
+// box bitset (one bit per cell, row-major), u32 pushes, u32 per push (cell << 2 | dp).
+void Sokoban::Save(vector<uint8_t>& out) const {
+    const auto rows = static_cast<int>(state.size());
+    const auto cols = static_cast<int>(state[0].size());
+    Put<uint32_t>(out, curLevel);
+    Put<uint64_t>(out, Fingerprint(levels[curLevel]));
+    Put<uint16_t>(out, rows);
+    Put<uint16_t>(out, cols);
+    Put<uint32_t>(out, playerPos.row * cols + playerPos.col);
+    Put<uint8_t> (out, Get(playerPos) & 3);
+
+    uint8_t bits = 0;
+    for (int c = 0; c < rows * cols; c++) {
+        if (state[c / cols][c % cols] & TILE_BOX)
+            bits |= 1 << (c % 8);
+        if (c % 8 == 7 || c == rows * cols - 1) {
+            out.push_back(bits);
+            bits = 0;
+        }
+    }
+
+    // the stack only shows its top: walk a copy, then write oldest first.
+    Put<uint32_t>(out, history.size());
+    auto journal = history;
+    auto end     = out.size() + 4 * history.size();
+    out.resize(end);
+    for (auto at = end; journal.size(); journal.pop()) {
+        auto [pos, dp] = journal.top();
+        uint32_t d = 0;
+        while (!(JOURNAL_DP[d] == dp))
+            d++;
+        uint32_t entry = (pos.row * cols + pos.col) << 2 | d;
+        at -= 4;
+        for (int i = 0; i < 4; i++)
+            out[at + i] = static_cast<uint8_t>(entry >> (8 * i));
+    }
+}
+
+bool Sokoban::Restore(const uint8_t* data, size_t size) {
+    Reader in {data, size};
+    auto level       = in.Get<uint32_t>();
+    auto fingerprint = in.Get<uint64_t>();
+    int  rows        = in.Get<uint16_t>();
+    int  cols        = in.Get<uint16_t>();
+    auto player      = in.Get<uint32_t>();
+    auto facing      = in.Get<uint8_t>();
+    auto boxBits     = in.Skip((rows * cols + 7) / 8);
+    auto numPushes   = in.Get<uint32_t>();
+    auto journal     = in.Skip(4 * static_cast<size_t>(numPushes));
+    if (!in.ok || in.at != size || level >= levels.size() || Fingerprint(levels[level]) != fingerprint)
+        return false;
+    const auto& saved = levels[level];
+    if (rows != saved.Rows() || cols != saved.Cols() || player >= static_cast<uint32_t>(rows * cols))
+        return false;
+
+    // the boxes only go on floor, as many as the level has, and the player next to them.
+    auto Char  = [&saved, cols](int c) { return saved.Row(c / cols)[c % cols]; };
+    auto Floor = [&Char](int c) { return Char(c) != '#' && Char(c) != '_'; };
+    auto IsBox = [boxBits](int c) { return (boxBits[c / 8] >> (c % 8)) & 1; };
+    int  boxes = 0, expected = 0;
+    for (int c = 0; c < rows * cols; c++) {
+        if (IsBox(c) && !Floor(c))
+            return false;
+        boxes    += IsBox(c);
+        expected += Char(c) == '$' || Char(c) == '*';
+    }
+    if (boxes != expected || !Floor(player) || IsBox(player))
+        return false;
+    auto Entry = [journal, cols](uint32_t i) -> pair<Pos, Pos> {
+        uint32_t entry = journal[4 * i] | journal[4 * i + 1] << 8 | journal[4 * i + 2] << 16 |
+                         static_cast<uint32_t>(journal[4 * i + 3]) << 24;
+        return {{static_cast<int>(entry >> 2) / cols, static_cast<int>(entry >> 2) % cols}, JOURNAL_DP[entry & 3]};
+    };
+
+    // Regret() pulls the journal back without checking (asserts only): it has to
+    // undo, pull by pull, down to the level's start, or it would make boxes up.
+    vector<uint8_t> box(rows * cols);
+    for (int c = 0; c < rows * cols; c++)
+        box[c] = IsBox(c);
+    auto Inside = [rows, cols](Pos p) { return p.row >= 0 && p.row < rows && p.col >= 0 && p.col < cols; };
+    auto Cell   = [cols](Pos p) { return p.row * cols + p.col; };
+    for (auto i = numPushes; i-- > 0; ) {
+        auto [pos, dp] = Entry(i);
+        if (pos.row >= rows)
+            return false;
+        auto from = pos - dp, to = pos + dp;
+        if (!Inside(from) || !Inside(to) || !Floor(Cell(from)) || !Floor(Cell(pos)) ||
+            box[Cell(from)] || box[Cell(pos)] || !box[Cell(to)])
+            return false;
+        box[Cell(to)]  = false;
+        box[Cell(pos)] = true;
+    }
+    for (int c = 0; c < rows * cols; c++)
+        if (box[c] != (Char(c) == '$' || Char(c) == '*'))
+            return false;
+    stack<pair<Pos, Pos>> restored;
+    for (uint32_t i = 0; i < numPushes; i++)
+        restored.push(Entry(i));
+
+    EnterLevel(level);
+    numBoxesOnTarget = 0;
+    for (int c = 0; c < rows * cols; c++) {
+        auto& tile = state[c / cols][c % cols];
+        tile = static_cast<TileType>(IsBox(c) ? (tile | TILE_BOX) : (tile & ~TILE_BOX));
+        numBoxesOnTarget += IsBox(c) && (tile & TILE_TARGET);
+    }
+    ClearPlayerPos();
+    SetPlayerPos({static_cast<int>(player) / cols, static_cast<int>(player) % cols}, 1, 0);
+    Get(playerPos) = static_cast<TileType>((Get(playerPos) & ~3) | (facing & 3));
+    history = std::move(restored);
+    return true;
+}
+
+namespace GameSession {
+
+static constexpr char MAGIC[4] = {'S', 'K', 'B', 'S'};
+
+void Encode(const Sokoban& game, uint8_t scene, vector<uint8_t>& out) {
+    out.assign(begin(MAGIC), end(MAGIC));
+    Put<uint16_t>(out, VERSION);
+    Put<uint8_t> (out, scene);
+    game.Save(out);
+    Put<uint64_t>(out, Fnv1a(out.data(), out.size()));
+}
+
+bool Decode(const vector<uint8_t>& data, Sokoban& game, uint8_t& scene) {
+    const size_t header = sizeof(MAGIC) + 2 + 1;
+    if (data.size() < header + 8 || !equal(begin(MAGIC), end(MAGIC), data.begin()))
+        return false;
+    Reader in {data.data(), data.size()};
+    in.Skip(sizeof(MAGIC));
+    auto version    = in.Get<uint16_t>();
+    auto savedScene = in.Get<uint8_t>();
+    Reader checksum {data.data() + data.size() - 8, 8};
+    if (version != VERSION || checksum.Get<uint64_t>() != Fnv1a(data.data(), data.size() - 8))
+        return false;
+    if (!game.Restore(data.data() + header, data.size() - header - 8))
+        return false;
+    scene = savedScene;
+    return true;
+}
+
+bool Load(const string& file, Sokoban& game, uint8_t& scene) {
+    ifstream fin(file, ios::binary);
+    if (!fin)
+        return false;
+    vector<uint8_t> data((istreambuf_iterator<char>(fin)), istreambuf_iterator<char>());
+    return Decode(data, game, scene);
+}
+
+void Writer::Save(const Sokoban& game, uint8_t scene) {
+    Encode(game, scene, encoded);
+    out.Submit(encoded.data(), encoded.size());
+}
+
+}
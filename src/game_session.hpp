@@ -0,0 +1,40 @@
+#pragma once
+
+#include "game.hpp"
+#include "game_file_writer.hpp"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Save and resume a whole game session.
+//
+// A session file is
+//   "SKBS", u16 format version, u8 gui scene,
+//   Sokoban::Save() (level, packed board, move journal),
+//   u64 FNV-1a of everything before it,
+// all little-endian. Encoding is a few microseconds, so it's done on the
+// main loop; the file is written by a BackgroundFileWriter, so a crash
+// never leaves half a session.
+namespace GameSession {
+
+static constexpr uint16_t VERSION = 1;
+
+void Encode(const Sokoban& game, uint8_t scene, std::vector<uint8_t>& out);
+// Only restores `game` and `scene` if the whole of `data` checks out.
+bool Decode(const std::vector<uint8_t>& data, Sokoban& game, uint8_t& scene);
+bool Load(const std::string& file, Sokoban& game, uint8_t& scene);
+
+class Writer {
+public:
+    explicit Writer(std::string file) : out(std::move(file)) {}
+
+    // Encode now, write later. Only the latest session not yet written is kept.
+    void Save(const Sokoban& game, uint8_t scene);
+
+private:
+    std::vector<uint8_t> encoded;  // reused, the main loop doesn't allocate once warm.
+    BackgroundFileWriter out;
+};
+
+}
@@ -0,0 +1,1044 @@
+#include "game_solver.hpp"
+#include "game_analysis.hpp"
+#include "game_transposition.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <cassert>
+#include <cctype>
+
+using namespace std;
+
+namespace GameSolver {
+
+// Where the boxes are: a byte per cell to look up, and the same as a
+// Bitboard<WORDS> to flood fill, unless WORDS is 0: the level fits none.
+template <size_t WORDS>
+struct BoxSet {
+    vector<uint8_t>             at;
+    Bitboard<WORDS ? WORDS : 1> bits;
+    const int32_t*              bitOf = nullptr;
+
+    bool operator[](int32_t c) const { return at[c]; }
+    void Assign(const LevelAnalysis& a) { at.assign(a.NumCells(), 0); bits = {}; bitOf = a.bitOf.data(); }
+    void Set  (int32_t c) { at[c] = true;  if constexpr (WORDS > 0) bits.Set(bitOf[c]);   }
+    void Reset(int32_t c) { at[c] = false; if constexpr (WORDS > 0) bits.Reset(bitOf[c]); }
+    void Clear() { fill(at.begin(), at.end(), 0); bits = {}; }
+};
+
+// Player flood fill with boxes as obstacles.
+// On levels that fit a Bitboard<WORDS>, the whole front moves at once, and
+// `bits` holds the reachable cells. Otherwise (WORDS is 0) it is a BFS, where
+// `mark[c] == stamp` means c is reachable, so there is no need to clear between calls.
+template <size_t WORDS>
+struct Reachability {
+    vector<uint32_t>            mark;
+    vector<int32_t>             dist;  // walking distance from start, valid where reachable (with `withDist` on bitboards).
+    vector<int32_t>             queue;
+    uint32_t                    stamp = 0;
+    Bitboard<WORDS ? WORDS : 1> bits;
+    const int32_t*              bitOf = nullptr;
+
+    bool operator[](int32_t c) const {
+        if constexpr (WORDS > 0)
+            return bits.Test(bitOf[c]);
+        else
+            return mark[c] == stamp;
+    }
+
+    // Return the smallest reachable cell, i.e., the normalized player position.
+    int32_t Flood(const LevelAnalysis& a, const BoxSet<WORDS>& boxAt, int32_t start, bool withDist) {
+        if (dist.size() != a.NumCells()) {
+            mark.assign(a.NumCells(), 0);
+            dist.resize(a.NumCells());
+        }
+        if constexpr (WORDS > 0)
+            return FloodBits(a, boxAt, start, withDist);
+        else
+            return FloodCells(a, boxAt, start);
+    }
+
+    int32_t FloodCells(const LevelAnalysis& a, const BoxSet<WORDS>& boxAt, int32_t start) {
+        stamp++;
+        queue.clear();
+        queue.push_back(start);
+        mark[start] = stamp;
+        dist[start] = 0;
+        int32_t minCell = start;
+        for (size_t i = 0; i < queue.size(); i++) {
+            for (auto delta : a.delta) {
+                auto next = queue[i] + delta;
+                if (!a.floor[next] || boxAt[next] || mark[next] == stamp)
+                    continue;
+                mark[next] = stamp;
+                dist[next] = dist[queue[i]] + 1;
+                minCell = min(minCell, next);
+                queue.push_back(next);
+            }
+        }
+        return minCell;
+    }
+
+    // Bits follow cells in order, so the lowest bit is the smallest cell.
+    int32_t FloodBits(const LevelAnalysis& a, const BoxSet<WORDS>& boxAt, int32_t start, bool withDist) {
+        Bitboard<WORDS> free, front;
+        for (size_t i = 0; i < WORDS; i++)
+            free.w[i] = a.floorBits.w[i] & ~boxAt.bits.w[i];
+        bitOf = a.bitOf.data();
+        bits  = {};
+        bits.Set(bitOf[start]);
+        front = bits;
+        dist[start] = 0;
+        const auto stride = a.boardStride;
+        for (int32_t d = 1; front.Any(); d++) {
+            front = (front.Shift(1) | front.Shift(-1) | front.Shift(stride) | front.Shift(-stride)) & free & ~bits;
+            bits |= front;
+            if (withDist)
+                front.ForEach([this, &a, d](int32_t b) { dist[a.bitCell[b]] = d; });
+        }
+        return a.bitCell[bits.Lowest()];
+    }
+};
+
+// IsFrozenSquare, with `goal` for targets.
+template <size_t WORDS>
+static bool IsFrozenBox(const LevelAnalysis& a, const vector<uint8_t>& goal, const BoxSet<WORDS>& boxAt, int32_t c) {
+    return IsFrozenSquare(c, a.cols, [&a](int32_t x) { return !a.floor[x]; },
+                          [&boxAt](int32_t x) { return boxAt[x]; },
+                          [&goal](int32_t x) { return goal[x] != 0; });
+}
+
+struct BoxPush {
+    int32_t box; // box cell before the push.
+    Dir     dir;
+};
+
+// BFS over the pushes of a single box, all other boxes fixed.
+// If `room` >= 0, the box stays inside that goal room (or its entrance).
+template <size_t WORDS>
+static bool FindBoxPath(const LevelAnalysis& a, BoxSet<WORDS>& boxAt, int32_t box, int32_t player,
+                        int32_t goal, int room, vector<BoxPush>* path) {
+    constexpr int32_t START = -2;
+    // state: box cell * NUM_DIRS + direction of the last push, which tells where the player is.
+    vector<int32_t> parent(a.NumCells() * NUM_DIRS, -1);
+    vector<int32_t> queue;
+    Reachability<WORDS> reach;
+    auto InRoom = [&](int32_t c) {
+        return room < 0 || a.goalRoom[c] == room || a.goalRooms[room].entrance == c;
+    };
+    auto Expand = [&](int32_t b, int32_t p, int32_t from) -> int32_t {
+        boxAt.Set(b);
+        reach.Flood(a, boxAt, p, false);
+        boxAt.Reset(b);
+        for (int d = 0; d < NUM_DIRS; d++) {
+            auto to = b + a.delta[d];
+            auto s  = to * NUM_DIRS + d;
+            if (!reach[b - a.delta[d]] || !a.floor[to] || boxAt[to] || a.dead[to] ||
+                !InRoom(to) || parent[s] != -1)
+                continue;
+            parent[s] = from;
+            if (to == goal)
+                return s;
+            queue.push_back(s);
+        }
+        return -1;
+    };
+
+    if (path)
+        path->clear();
+    if (box == goal)
+        return true;
+    boxAt.Reset(box);
+    auto found = Expand(box, player, START);
+    for (size_t i = 0; found < 0 && i < queue.size(); i++) {
+        auto b = queue[i] / NUM_DIRS;
+        auto d = queue[i] % NUM_DIRS;
+        found = Expand(b, b - a.delta[d], queue[i]);
+    }
+    boxAt.Set(box);
+    if (found < 0)
+        return false;
+    for (auto s = found; path && s != START; s = parent[s]) {
+        auto d = static_cast<Dir>(s % NUM_DIRS);
+        path->push_back({s / NUM_DIRS - a.delta[d], d});
+    }
+    if (path)
+        reverse(path->begin(), path->end());
+    return true;
+}
+
+// One push (or macro push) generated from a position.
+struct Child {
+    int32_t box;    // box cell before the push.
+    int32_t to;     // box cell after the (last) push.
+    int32_t player; // player cell after the (last) push.
+    int32_t g;
+    int32_t h;
+    Dir     dir;
+};
+
+// A push of a solution, as much as Reconstruct needs to know.
+struct Step {
+    int32_t boxFrom; // box cell before the (first) push.
+    int32_t boxTo;   // box cell after the (last) push, differs from boxFrom + delta for macros.
+    Dir     dir;
+};
+
+// A region the player can't reach, and what pushes of its fence boxes do.
+struct Corral {
+    int32_t parent     = 0;     // merged into that corral, if not itself.
+    int32_t pushesIn   = 0;     // possible pushes of fence boxes into the corral.
+    bool    pi         = true;  // every fence push goes in (I), and is possible now (P).
+    bool    unfinished = false; // holds an empty target, or is fenced by a box off target.
+    bool    emptyGoal  = false; // of this part, before merging.
+    bool    chosen     = false; // part of the corral pushes are limited to.
+};
+
+// Working memory of one searching thread.
+template <size_t WORDS>
+struct Scratch {
+    BoxSet<WORDS>         boxAt;
+    Reachability<WORDS>   reach;      // of the position being expanded.
+    Reachability<WORDS>   childReach;
+    vector<Child>         children;
+    deque<vector<Child>>  childrenAt; // per depth, for the depth-first search.
+    vector<uint64_t>      bits;       // transposition table key.
+
+    // corrals of the position being expanded, corralOf[c] is valid where corralMark[c] == corralStamp.
+    vector<int32_t>       corralOf;
+    vector<uint32_t>      corralMark;
+    uint32_t              corralStamp = 0;
+    vector<int32_t>       corralQueue;
+    vector<Corral>        corrals;
+    vector<pair<int32_t, int32_t>> fence;  // (box, corral) pairs.
+    // corral deadlock search, on the fence boxes alone.
+    BoxSet<WORDS>         subBoxAt;
+    Reachability<WORDS>   subReach;
+    vector<int32_t>       subPool;    // boxes of every node, sorted.
+    vector<int32_t>       subBoxes;
+    vector<int32_t>       subPlayer;
+    vector<int32_t>       subNorm;    // normalized player of every node looked at.
+    unordered_multimap<uint64_t, int32_t> subSeen;  // hash to node, checked against its boxes.
+    // is the corral, fence boxes and player region, a deadlock. Keyed by hash, and
+    // checked against the key stored at `key` in corralKeys: a collision is a miss.
+    struct CorralEntry {
+        size_t key;
+        bool   deadlock;
+    };
+    unordered_map<uint64_t, CorralEntry> corralDeadlocks;
+    vector<uint64_t>      corralKeys; // per entry: normalized player, then a bit per cell of the fence boxes.
+    vector<uint64_t>      corralKey;  // of the corral looked up.
+
+    int32_t CorralOf(int32_t c) const { return corralMark[c] == corralStamp ? corralOf[c] : -1; }
+};
+
+// WORDS: the Bitboard instance of the level, 0 if it fits none.
+// What Incremental needs of a Search, whichever its bitboard size.
+struct SearchSteps {
+    virtual ~SearchSteps() = default;
+    virtual bool Advance(Result& result, int64_t nodes) = 0;
+};
+
+template <size_t WORDS>
+class Search : public SearchSteps {
+public:
+    Search(const Sokoban& game, const Sokoban* goal, const Options& options)
+        : a(game.GetAnalysis()), options(options) {
+        startBoxes  = BoxCells(game);
+        startPlayer = a.Cell(game.GetPlayerPos());
+        numBoxes    = static_cast<int32_t>(startBoxes.size());
+        exactPlayer = options.metric == Metric::MOVES;
+        useMacros   = options.useMacros && !goal && !exactPlayer;
+        useCorrals  = options.usePiCorrals && !goal && !exactPlayer;
+
+        if (goal) {
+            goalCell.assign(a.NumCells(), 0);
+            for (auto c : BoxCells(*goal))
+                goalCell[c] = true;
+            goalPlayer = a.Cell(goal->GetPlayerPos());
+            distance   = PushDistance(a, goalCell);
+        } else {
+            goalCell = a.target;
+            distance = a.distance;
+        }
+
+        mt19937_64 rng(0x5ce11a);
+        boxKeys.resize(a.NumCells());
+        playerKeys.resize(a.NumCells());
+        for (auto& k : boxKeys)    k = rng();
+        for (auto& k : playerKeys) k = rng();
+
+        entranceOf.assign(a.NumCells(), -1);
+        for (size_t r = 0; r < a.goalRooms.size(); r++)
+            entranceOf[a.goalRooms[r].entrance] = static_cast<int16_t>(r);
+        main.boxAt.Assign(a);
+    }
+
+    Result Run() {
+        Result result;
+        if (!Reachable())
+            return result;
+        Finish(result, options.memoryBudget ? RunBounded(result) : RunAStar(result));
+        return result;
+    }
+
+    // A* `nodes` expansions at a time, see Incremental.
+    bool Advance(Result& result, int64_t nodes) override {
+        if (!started) {
+            started = true;
+            if (!Reachable())
+                return true;
+            StartAStar();
+        }
+        if (!StepAStar(result, nodes))
+            return false;
+        Finish(result, AStarPath(result));
+        return true;
+    }
+
+private:
+    struct Node {
+        uint64_t hash;
+        int32_t  parent;
+        int32_t  boxFrom;
+        int32_t  boxTo;
+        int32_t  player;  // normalized, or exact if optimizing moves.
+        int32_t  g;       // cost so far.
+        int32_t  h;       // sum of distance[] over all boxes.
+        int32_t  finish;  // once h == 0, the walk to goalPlayer (-1: can't get there).
+        Dir      dir;
+        bool     closed;
+    };
+    struct NodeHash {
+        const Search* s;
+        size_t operator()(int32_t i) const { return s->nodes[i].hash; }
+    };
+    struct NodeEqual {
+        const Search* s;
+        bool operator()(int32_t i, int32_t j) const {
+            return s->nodes[i].player == s->nodes[j].player &&
+                   equal(s->Boxes(i), s->Boxes(i) + s->numBoxes, s->Boxes(j));
+        }
+    };
+    struct Open {
+        int32_t f, g, node;
+        bool operator<(const Open& rhs) const { return f != rhs.f ? f > rhs.f : g < rhs.g; }
+    };
+    // What a depth-first search thread needs besides its Scratch.
+    struct Worker {
+        Scratch<WORDS>  s;
+        mt19937         rng;
+        bool            helper;     // shuffles its move order, not trusted to call a search exhausted.
+        int64_t         expanded = 0;
+        int32_t         nextBound;
+        vector<int32_t> boxes;      // current position, unsorted.
+        vector<Step>    path;
+    };
+
+    vector<int32_t> BoxCells(const Sokoban& game) const {
+        vector<int32_t> boxes;
+        const auto& state = game.GetState();
+        for (int32_t c = 0; c < a.NumCells(); c++)
+            if (a.floor[c] && (state[c / a.cols][c % a.cols] & TILE_BOX))
+                boxes.push_back(c);
+        return boxes;
+    }
+    const int32_t* Boxes(int32_t i) const { return boxPool.data() + static_cast<size_t>(i) * numBoxes; }
+    int32_t* Boxes(int32_t i) { return boxPool.data() + static_cast<size_t>(i) * numBoxes; }
+    static int32_t F(int32_t g, int32_t h, int32_t finish) { return g + h + max(finish, 0); }
+    static bool IsGoal(int32_t h, int32_t finish) { return h == 0 && finish >= 0; }
+    bool Reachable() const {
+        return none_of(startBoxes.begin(), startBoxes.end(), [this](int32_t c) { return distance[c] == LevelAnalysis::UNREACHABLE; });
+    }
+    void Finish(Result& result, const vector<Step>& steps) {
+        if (!result.solved)
+            return;
+        result.lurd   = Reconstruct(steps);
+        result.moves  = static_cast<int32_t>(result.lurd.size());
+        result.pushes = static_cast<int32_t>(count_if(result.lurd.begin(), result.lurd.end(), ::isupper));
+    }
+    // With s.boxAt updated, flood from the player. Return the player key, set `finish`.
+    int32_t Arrive(Scratch<WORDS>& s, int32_t player, int32_t h, int32_t& finish) const {
+        auto norm = s.childReach.Flood(a, s.boxAt, player, exactPlayer && h == 0);
+        finish    = 0;
+        if (h == 0 && goalPlayer >= 0)
+            finish = !s.childReach[goalPlayer] ? -1 : exactPlayer ? s.childReach.dist[goalPlayer] : 0;
+        return exactPlayer ? player : norm;
+    }
+
+    int32_t ApplyMacros(Scratch<WORDS>& s, int32_t box, Dir d, int32_t& player, int32_t& pushes) const;
+    int32_t FindPiCorral(Scratch<WORDS>& s, const vector<int32_t>& boxes) const;
+    bool    IsCorralDeadlock(Scratch<WORDS>& s, int32_t player) const;
+    void    Generate(Scratch<WORDS>& s, const vector<int32_t>& boxes, int32_t player, int32_t g, int32_t h, vector<Child>& out) const;
+    void    Expand(int32_t i);
+    bool    Dfs(Worker& w, int32_t depth, int32_t player, uint64_t hash, int32_t g, int32_t h, int32_t finish, int32_t bound);
+    void    StartAStar();
+    bool    StepAStar(Result& result, int64_t nodes);
+    vector<Step> AStarPath(Result& result) const;
+    vector<Step> RunAStar(Result& result) {
+        StartAStar();
+        StepAStar(result, INT64_MAX);
+        return AStarPath(result);
+    }
+    vector<Step> RunBounded(Result& result);
+    string  Reconstruct(const vector<Step>& steps);
+
+    const LevelAnalysis& a;
+    const Options&       options;
+    vector<int32_t>      startBoxes;
+    int32_t              startPlayer;
+    int32_t              numBoxes;
+    bool                 exactPlayer;
+    bool                 useMacros;
+    bool                 useCorrals;
+    vector<uint8_t>      goalCell;
+    int32_t              goalPlayer = -1;
+    vector<int32_t>      distance;
+    vector<uint64_t>     boxKeys;
+    vector<uint64_t>     playerKeys;
+    vector<int16_t>      entranceOf;
+    Scratch<WORDS>       main;
+
+    // A*
+    vector<Node>         nodes;
+    vector<int32_t>      boxPool;
+    unordered_set<int32_t, NodeHash, NodeEqual> visited {0, NodeHash{this}, NodeEqual{this}};
+    priority_queue<Open> open;
+    vector<int32_t>      parentBoxes;
+    int32_t              solution = -1;
+    bool                 started  = false;  // Advance() only.
+
+    // memory-bounded iterative deepening
+    unique_ptr<TranspositionTable> table;
+    vector<int32_t>      liveIndex;  // bit of each live cell in a table key.
+    atomic<bool>         stop {false};
+    atomic<int64_t>      totalExpanded {0};
+};
+
+// Keep pushing through tunnels, then drop a box arriving at a goal room
+// entrance straight onto the next free target of that room.
+// Return the final box cell, update player and pushes accordingly.
+template <size_t WORDS>
+int32_t Search<WORDS>::ApplyMacros(Scratch<WORDS>& s, int32_t box, Dir d, int32_t& player, int32_t& pushes) const {
+    auto& boxAt = s.boxAt;
+    while ((a.tunnel[box] & (1 << d)) && !a.target[box] && entranceOf[box] < 0) {
+        auto next = box + a.delta[d];
+        if (!a.floor[next] || boxAt[next] || a.dead[next])
+            break;
+        player = box;
+        box    = next;
+        pushes++;
+    }
+    auto r = entranceOf[box];
+    if (r < 0 || a.goalRoom[player] == r)
+        return box;
+
+    // only when the room is filled exactly in order so far.
+    const auto& room = a.goalRooms[r];
+    size_t filled = 0;
+    while (filled < room.fillOrder.size() && boxAt[room.fillOrder[filled]])
+        filled++;
+    if (filled == room.fillOrder.size())
+        return box;
+    auto inRoom = count_if(room.cells.begin(), room.cells.end(), [&boxAt](int32_t c) { return boxAt[c]; });
+    if (inRoom != static_cast<ptrdiff_t>(filled))
+        return box;
+
+    vector<BoxPush> path;
+    boxAt.Set(box);
+    bool found = FindBoxPath(a, boxAt, box, player, room.fillOrder[filled], r, &path);
+    boxAt.Reset(box);
+    if (!found)
+        return box;
+    pushes += static_cast<int32_t>(path.size());
+    player  = path.back().box;
+    return path.back().box + a.delta[path.back().dir];
+}
+
+// List the pushes from the position of `boxes` (marked in s.boxAt) and `player`.
+template <size_t WORDS>
+void Search<WORDS>::Generate(Scratch<WORDS>& s, const vector<int32_t>& boxes, int32_t player, int32_t g, int32_t h, vector<Child>& out) const {
+    out.clear();
+    s.reach.Flood(a, s.boxAt, player, exactPlayer);
+    auto corral = useCorrals ? FindPiCorral(s, boxes) : -1;
+    if (corral >= 0 && IsCorralDeadlock(s, player))
+        return;
+    for (auto box : boxes) {
+        for (int d = 0; d < NUM_DIRS; d++) {
+            auto to = box + a.delta[d];
+            if (!s.reach[box - a.delta[d]] || !a.floor[to] || s.boxAt[to] || distance[to] == LevelAnalysis::UNREACHABLE)
+                continue;
+            if (corral >= 0 && (s.CorralOf(to) < 0 || !s.corrals[s.CorralOf(to)].chosen))
+                continue;
+
+            Child c;
+            c.box    = box;
+            c.dir    = static_cast<Dir>(d);
+            c.player = box;
+            int32_t pushes = 1;
+            s.boxAt.Reset(box);
+            if (useMacros)
+                to = ApplyMacros(s, to, c.dir, c.player, pushes);
+            s.boxAt.Set(to);
+            c.to = to;
+            c.g  = g + pushes + (exactPlayer ? s.reach.dist[box - a.delta[d]] : 0);
+            c.h  = h - distance[box] + distance[to];
+            if (c.g + c.h <= options.maxCost && !IsFrozenBox(a, goalCell, s.boxAt, to))
+                out.push_back(c);
+            s.boxAt.Reset(to);
+            s.boxAt.Set(box);
+        }
+    }
+}
+
+// Label the corrals around the fence boxes, with s.reach up to date. Corrals
+// that fence pushes lead from one into the other are merged, and looked at as one.
+// Return the unfinished PI-corral with the fewest pushes into it, -1 if there
+// is none. Its parts are marked `chosen`.
+template <size_t WORDS>
+int32_t Search<WORDS>::FindPiCorral(Scratch<WORDS>& s, const vector<int32_t>& boxes) const {
+    if (s.corralMark.size() != a.NumCells()) {
+        s.corralMark.assign(a.NumCells(), 0);
+        s.corralOf.resize(a.NumCells());
+    }
+    s.corralStamp++;
+    s.corrals.clear();
+    s.fence.clear();
+    auto IsFree = [&](int32_t c) { return a.floor[c] && !s.boxAt[c]; };
+    for (auto box : boxes) {
+        int32_t seen[NUM_DIRS];
+        int32_t numSeen = 0;
+        for (auto delta : a.delta) {
+            auto start = box + delta;
+            if (!IsFree(start) || s.reach[start])
+                continue;
+            auto k = s.CorralOf(start);
+            if (k < 0) {
+                k = static_cast<int32_t>(s.corrals.size());
+                s.corrals.push_back({});
+                s.corrals[k].parent = k;
+                s.corralQueue.assign(1, start);
+                s.corralMark[start] = s.corralStamp;
+                s.corralOf[start]   = k;
+                for (size_t i = 0; i < s.corralQueue.size(); i++) {
+                    auto c = s.corralQueue[i];
+                    s.corrals[k].emptyGoal |= goalCell[c] != 0;
+                    for (auto dc : a.delta) {
+                        auto next = c + dc;
+                        if (IsFree(next) && s.corralMark[next] != s.corralStamp) {
+                            s.corralMark[next] = s.corralStamp;
+                            s.corralOf[next]   = k;
+                            s.corralQueue.push_back(next);
+                        }
+                    }
+                }
+            }
+            if (find(seen, seen + numSeen, k) == seen + numSeen) {
+                seen[numSeen++] = k;
+                s.fence.push_back({box, k});
+            }
+        }
+    }
+    if (s.corrals.empty())
+        return -1;
+
+    auto Find = [&s](int32_t k) {
+        while (s.corrals[k].parent != k)
+            k = s.corrals[k].parent = s.corrals[s.corrals[k].parent].parent;
+        return k;
+    };
+    for (bool merged = true; merged; ) {
+        merged = false;
+        for (auto& c : s.corrals) {
+            c.pushesIn   = 0;
+            c.pi         = true;
+            c.unfinished = false;
+        }
+        for (auto& c : s.corrals)
+            s.corrals[Find(static_cast<int32_t>(&c - s.corrals.data()))].unfinished |= c.emptyGoal;
+        for (auto [box, k] : s.fence) {
+            auto& corral = s.corrals[Find(k)];
+            corral.unfinished |= !goalCell[box];
+            for (auto delta : a.delta) {
+                auto from = box - delta;
+                auto to   = box + delta;
+                if (!IsFree(to) || distance[to] == LevelAnalysis::UNREACHABLE)
+                    continue;
+                auto other = s.CorralOf(to);
+                bool into  = other >= 0 && Find(other) == Find(k);
+                if (s.reach[from] && other >= 0 && !into) {
+                    s.corrals[Find(other)].parent = Find(k);  // one corral opens into the other.
+                    merged = true;
+                } else if (s.reach[from]) {
+                    corral.pushesIn += into;
+                    corral.pi       &= into;
+                } else if (into && IsFree(from)) {
+                    corral.pi = false;  // a push in, but the player can't get there yet.
+                }
+            }
+        }
+    }
+    int32_t best = -1;
+    for (int32_t k = 0; k < static_cast<int32_t>(s.corrals.size()); k++) {
+        const auto& c = s.corrals[k];
+        if (Find(k) == k && c.pi && c.unfinished && c.pushesIn > 0 && (best < 0 || c.pushesIn < s.corrals[best].pushesIn))
+            best = k;
+    }
+    for (int32_t k = 0; k < static_cast<int32_t>(s.corrals.size()); k++)
+        s.corrals[k].chosen = best >= 0 && Find(k) == best;
+    return best;
+}
+
+// Search pushes of the fence boxes of the chosen corral alone, every other box
+// taken off the board, for a position with all of them on targets. Taking boxes
+// away only makes it easier: if even that fails, the position is dead.
+// Small searches only, a search cut short is not a deadlock. Results are
+// kept by fence boxes and player region, compared in full on lookup.
+template <size_t WORDS>
+bool Search<WORDS>::IsCorralDeadlock(Scratch<WORDS>& s, int32_t player) const {
+    constexpr size_t MAX_NODES   = 256;
+    constexpr size_t MAX_ENTRIES = 1 << 16;
+
+    auto& boxAt = s.subBoxAt;
+    if (boxAt.at.size() != a.NumCells())
+        boxAt.Assign(a);
+    s.subPool.clear();
+    s.subPlayer.clear();
+    for (auto [box, k] : s.fence)
+        if (s.corrals[k].chosen)
+            s.subPool.push_back(box);
+    sort(s.subPool.begin(), s.subPool.end());
+    s.subPool.erase(unique(s.subPool.begin(), s.subPool.end()), s.subPool.end());
+    const auto m = s.subPool.size();
+
+    auto Key = [&](const int32_t* boxes, int32_t norm) {
+        uint64_t key = playerKeys[norm];
+        for (size_t i = 0; i < m; i++)
+            key ^= boxKeys[boxes[i]];
+        return key;
+    };
+    for (size_t i = 0; i < m; i++)
+        boxAt.Set(s.subPool[i]);
+    auto startNorm = s.subReach.Flood(a, boxAt, player, false);
+    auto startKey  = Key(s.subPool.data(), startNorm);
+    for (size_t i = 0; i < m; i++)
+        boxAt.Reset(s.subPool[i]);
+    const size_t keyWords = 1 + (a.NumCells() + 63) / 64;
+    s.corralKey.assign(keyWords, 0);
+    s.corralKey[0] = static_cast<uint64_t>(startNorm);
+    for (size_t i = 0; i < m; i++)
+        s.corralKey[1 + s.subPool[i] / 64] |= 1ULL << (s.subPool[i] % 64);
+    auto cached = s.corralDeadlocks.find(startKey);
+    if (cached != s.corralDeadlocks.end() &&
+        equal(s.corralKey.begin(), s.corralKey.end(), s.corralKeys.begin() + cached->second.key))
+        return cached->second.deadlock;
+
+    s.subPlayer.push_back(player);
+    s.subSeen.clear();
+    bool deadlock = true;
+    size_t expanded = 0;
+    for (size_t i = 0; i < s.subPlayer.size() && deadlock; i++) {
+        if (++expanded > MAX_NODES) {
+            deadlock = false;
+            break;
+        }
+        // a copy: pushing children may move the pool.
+        auto& boxes = s.subBoxes;
+        boxes.assign(s.subPool.begin() + i * m, s.subPool.begin() + (i + 1) * m);
+        bool solved = true;
+        for (size_t j = 0; j < m; j++) {
+            boxAt.Set(boxes[j]);
+            solved &= goalCell[boxes[j]] != 0;
+        }
+        auto norm = s.subReach.Flood(a, boxAt, s.subPlayer[i], false);
+        auto key  = Key(boxes.data(), norm);
+        auto seen = s.subSeen.equal_range(key);
+        auto Same = [&](const pair<const uint64_t, int32_t>& e) {
+            return s.subNorm[e.second] == norm && equal(boxes.begin(), boxes.end(), s.subPool.begin() + e.second * m);
+        };
+        s.subNorm.resize(s.subPlayer.size());
+        s.subNorm[i] = norm;
+        if (solved) {
+            deadlock = false;
+        } else if (none_of(seen.first, seen.second, Same)) {
+            s.subSeen.emplace(key, static_cast<int32_t>(i));
+            for (size_t j = 0; j < m; j++) {
+                auto box = boxes[j];
+                for (auto delta : a.delta) {
+                    auto to = box + delta;
+                    if (!s.subReach[box - delta] || !a.floor[to] || boxAt[to] || distance[to] == LevelAnalysis::UNREACHABLE)
+                        continue;
+                    boxAt.Reset(box);
+                    boxAt.Set(to);
+                    if (!IsFrozenBox(a, goalCell, boxAt, to)) {
+                        boxes[j] = to;
+                        s.subPool.insert(s.subPool.end(), boxes.begin(), boxes.end());
+                        sort(s.subPool.end() - m, s.subPool.end());
+                        s.subPlayer.push_back(box);
+                        boxes[j] = box;
+                    }
+                    boxAt.Reset(to);
+                    boxAt.Set(box);
+                }
+            }
+        }
+        for (size_t j = 0; j < m; j++)
+            boxAt.Reset(boxes[j]);
+    }
+    if (s.corralDeadlocks.size() >= MAX_ENTRIES || s.corralKeys.size() >= MAX_ENTRIES * keyWords) {
+        s.corralDeadlocks.clear();
+        s.corralKeys.clear();
+    }
+    s.corralDeadlocks[startKey] = {s.corralKeys.size(), deadlock};
+    s.corralKeys.insert(s.corralKeys.end(), s.corralKey.begin(), s.corralKey.end());
+    return deadlock;
+}
+
+template <size_t WORDS>
+void Search<WORDS>::Expand(int32_t i) {
+    auto& s = main;
+    const Node node = nodes[i];
+    nodes[i].closed = true;
+    parentBoxes.assign(Boxes(i), Boxes(i) + numBoxes);
+    for (auto box : parentBoxes)
+        s.boxAt.Set(box);
+    Generate(s, parentBoxes, node.player, node.g, node.h, s.children);
+
+    for (auto& c : s.children) {
+        s.boxAt.Reset(c.box);
+        s.boxAt.Set(c.to);
+        Node n;
+        n.parent  = i;
+        n.boxFrom = c.box;
+        n.boxTo   = c.to;
+        n.dir     = c.dir;
+        n.closed  = false;
+        n.g       = c.g;
+        n.h       = c.h;
+        n.player  = Arrive(s, c.player, n.h, n.finish);
+        n.hash    = node.hash ^ boxKeys[c.box] ^ boxKeys[c.to] ^ playerKeys[node.player] ^ playerKeys[n.player];
+        s.boxAt.Reset(c.to);
+        s.boxAt.Set(c.box);
+
+        int32_t child = static_cast<int32_t>(nodes.size());
+        nodes.push_back(n);
+        boxPool.insert(boxPool.end(), parentBoxes.begin(), parentBoxes.end());
+        auto* boxes = Boxes(child);
+        *find(boxes, boxes + numBoxes, c.box) = c.to;
+        sort(boxes, boxes + numBoxes);
+
+        auto [it, inserted] = visited.insert(child);
+        if (!inserted) {
+            nodes.pop_back();
+            boxPool.resize(boxPool.size() - numBoxes);
+            // reopen if cheaper, h is consistent so closed nodes are final.
+            auto& old = nodes[*it];
+            if (!old.closed && n.g < old.g) {
+                old.parent  = n.parent;
+                old.boxFrom = n.boxFrom;
+                old.boxTo   = n.boxTo;
+                old.dir     = n.dir;
+                old.g       = n.g;
+                open.push({F(old.g, old.h, old.finish), old.g, *it});
+            }
+        } else if (F(n.g, n.h, n.finish) <= options.maxCost) {
+            open.push({F(n.g, n.h, n.finish), n.g, child});
+        }
+    }
+    for (auto box : parentBoxes)
+        s.boxAt.Reset(box);
+}
+
+template <size_t WORDS>
+void Search<WORDS>::StartAStar() {
+    auto& s = main;
+    Node root {};
+    root.parent = -1;
+    for (auto c : startBoxes) {
+        s.boxAt.Set(c);
+        root.h    += distance[c];
+        root.hash ^= boxKeys[c];
+    }
+    root.player = Arrive(s, startPlayer, root.h, root.finish);
+    root.hash  ^= playerKeys[root.player];
+    s.boxAt.Clear();
+    nodes.push_back(root);
+    boxPool = startBoxes;
+    sort(boxPool.begin(), boxPool.end());
+    visited.insert(0);
+    open.push({F(root.g, root.h, root.finish), 0, 0});
+}
+
+// Expand up to `budget` more nodes. Return true once the search is over, solved or not.
+template <size_t WORDS>
+bool Search<WORDS>::StepAStar(Result& result, int64_t budget) {
+    const auto first = result.nodesExpanded;
+    while (open.size() && static_cast<int64_t>(nodes.size()) < options.maxNodes) {
+        if (result.nodesExpanded - first >= budget)
+            return false;
+        auto top = open.top();
+        open.pop();
+        const auto& node = nodes[top.node];
+        if (node.closed || top.g != node.g)
+            continue; // stale entry, reopened with a lower cost.
+        if (IsGoal(node.h, node.finish)) {
+            solution = top.node;
+            break;
+        }
+        if (options.cancel && options.cancel->load(memory_order_relaxed))
+            break;
+        if ((++result.nodesExpanded & 1023) == 0 && chrono::steady_clock::now() > options.deadline)
+            break;
+        Expand(top.node);
+    }
+    return true;
+}
+
+template <size_t WORDS>
+vector<Step> Search<WORDS>::AStarPath(Result& result) const {
+    vector<Step> steps;
+    for (auto i = solution; i > 0; i = nodes[i].parent)
+        steps.push_back({nodes[i].boxFrom, nodes[i].boxTo, nodes[i].dir});
+    reverse(steps.begin(), steps.end());
+    result.solved = solution >= 0;
+    return steps;
+}
+
+// IDA*: depth-first up to a bound on f, raised to the smallest f that didn't
+// fit, until a solution fits. Memory is the path plus the transposition table.
+// Helper threads run the same iterations in a shuffled order and share the
+// table with the main thread, so they mostly keep it from re-searching.
+template <size_t WORDS>
+bool Search<WORDS>::Dfs(Worker& w, int32_t depth, int32_t player, uint64_t hash, int32_t g, int32_t h, int32_t finish, int32_t bound) {
+    auto f = F(g, h, finish);
+    if (f > bound) {
+        w.nextBound = min(w.nextBound, f);
+        return false;
+    }
+    if (IsGoal(h, finish))
+        return true;
+    if (stop.load(memory_order_relaxed))
+        return false;
+    if ((++w.expanded & 1023) == 0) {
+        if (totalExpanded.fetch_add(1024, memory_order_relaxed) >= options.maxNodes ||
+            (options.cancel && options.cancel->load(memory_order_relaxed)) ||
+            chrono::steady_clock::now() > options.deadline)
+            stop = true;
+    }
+
+    auto& s = w.s;
+    if (s.childrenAt.size() <= depth)
+        s.childrenAt.resize(depth + 1);
+    auto& children = s.childrenAt[depth];
+    Generate(s, w.boxes, player, g, h, children);
+    if (w.helper)
+        shuffle(children.begin(), children.end(), w.rng);
+    stable_sort(children.begin(), children.end(), [](const Child& x, const Child& y) { return x.h < y.h; });
+
+    for (auto& c : children) {
+        s.boxAt.Reset(c.box);
+        s.boxAt.Set(c.to);
+        auto it = find(w.boxes.begin(), w.boxes.end(), c.box);
+        *it = c.to;
+
+        int32_t childFinish;
+        int32_t childPlayer = Arrive(s, c.player, c.h, childFinish);
+        uint64_t childHash  = hash ^ boxKeys[c.box] ^ boxKeys[c.to] ^ playerKeys[player] ^ playerKeys[childPlayer];
+        fill(s.bits.begin(), s.bits.end(), 0);
+        for (auto box : w.boxes)
+            s.bits[liveIndex[box] / 64] |= 1ULL << (liveIndex[box] % 64);
+
+        bool found = false;
+        switch (table->Visit(childHash, s.bits.data(), childPlayer, c.g, bound)) {
+        case TranspositionTable::VISIT_NEW: {
+            w.path.push_back({c.box, c.to, c.dir});
+            found = Dfs(w, depth + 1, childPlayer, childHash, c.g, c.h, childFinish, bound);
+            if (!found)
+                w.path.pop_back();
+        } break;
+        case TranspositionTable::VISIT_CHEAPER:
+            break;
+        case TranspositionTable::VISIT_SAME: {
+            // another thread may still be on it, don't call this iteration exhausted.
+            if (options.numThreads > 1)
+                w.nextBound = min(w.nextBound, bound + 1);
+        } break;
+        }
+        *it = c.box;
+        s.boxAt.Reset(c.to);
+        s.boxAt.Set(c.box);
+        if (found)
+            return true;
+    }
+    return false;
+}
+
+template <size_t WORDS>
+vector<Step> Search<WORDS>::RunBounded(Result& result) {
+    int32_t numLive = 0;
+    liveIndex.assign(a.NumCells(), -1);
+    for (int32_t c = 0; c < a.NumCells(); c++)
+        if (a.floor[c] && distance[c] != LevelAnalysis::UNREACHABLE)
+            liveIndex[c] = numLive++;
+    table = make_unique<TranspositionTable>(options.memoryBudget, numLive);
+
+    int32_t  rootH = 0, rootFinish;
+    uint64_t rootHash = 0;
+    for (auto c : startBoxes) {
+        main.boxAt.Set(c);
+        rootH    += distance[c];
+        rootHash ^= boxKeys[c];
+    }
+    int32_t rootPlayer = Arrive(main, startPlayer, rootH, rootFinish);
+    rootHash ^= playerKeys[rootPlayer];
+    main.boxAt.Clear();
+
+    std::mutex   solutionMutex;
+    vector<Step> steps;
+    auto Run = [&](int id) {
+        Worker w;
+        w.s.boxAt.Assign(a);
+        w.s.bits.resize(table->BitsetWords());
+        w.rng.seed(id);
+        w.helper = id > 0;
+        w.boxes  = startBoxes;
+        for (auto c : startBoxes)
+            w.s.boxAt.Set(c);
+        for (int32_t bound = F(0, rootH, rootFinish); bound <= options.maxCost && !stop; bound = w.nextBound) {
+            w.nextBound = INT32_MAX;
+            if (Dfs(w, 0, rootPlayer, rootHash, 0, rootH, rootFinish, bound)) {
+                lock_guard<std::mutex> lock(solutionMutex);
+                if (!result.solved) {
+                    result.solved = true;
+                    steps = w.path;
+                }
+                stop = true;
+            }
+            if (w.nextBound == INT32_MAX) {
+                stop = stop || !w.helper; // exhausted: there is no solution.
+                break;
+            }
+        }
+        totalExpanded += w.expanded & 1023;
+    };
+    vector<thread> helpers;
+    for (int i = 1; i < options.numThreads; i++)
+        helpers.emplace_back(Run, i);
+    Run(0);
+    stop = true;
+    for (auto& t : helpers)
+        t.join();
+    result.nodesExpanded = totalExpanded;
+    return steps;
+}
+
+template <size_t WORDS>
+string Search<WORDS>::Reconstruct(const vector<Step>& steps) {
+    auto& boxAt = main.boxAt;
+    auto& reach = main.reach;
+    string lurd;
+    int32_t player = startPlayer;
+    for (auto c : startBoxes)
+        boxAt.Set(c);
+
+    // shortest walk: flood from the destination, then step downhill from the player.
+    auto WalkTo = [&](int32_t target) {
+        reach.Flood(a, boxAt, target, true);
+        assert(reach[player]);
+        while (player != target) {
+            for (int k = 0; k < NUM_DIRS; k++) {
+                auto next = player + a.delta[k];
+                if (reach[next] && reach.dist[next] == reach.dist[player] - 1) {
+                    lurd += LURD[k];
+                    player = next;
+                    break;
+                }
+            }
+        }
+    };
+    auto PushFrom = [&](int32_t box, Dir d) {
+        WalkTo(box - a.delta[d]);
+        lurd += static_cast<char>(LURD[d] - 'a' + 'A');
+        boxAt.Reset(box);
+        boxAt.Set(box + a.delta[d]);
+        player = box;
+    };
+
+    vector<BoxPush> path;
+    for (auto& step : steps) {
+        PushFrom(step.boxFrom, step.dir);
+        auto box = step.boxFrom + a.delta[step.dir];
+        if (box == step.boxTo)
+            continue;
+        [[maybe_unused]] bool found = FindBoxPath(a, boxAt, box, player, step.boxTo, -1, &path);
+        assert(found);
+        for (auto p : path)
+            PushFrom(p.box, p.dir);
+    }
+    if (goalPlayer >= 0)
+        WalkTo(goalPlayer);
+    boxAt.Clear();
+    return lurd;
+}
+
+// The search instance for the level's bitboard, picked once per solve.
+static Result RunSearch(const Sokoban& game, const Sokoban* goal, const Options& options) {
+    switch (game.GetAnalysis().boardWords) {
+    case 1: return Search<1>(game, goal, options).Run();
+    case 2: return Search<2>(game, goal, options).Run();
+    case 4: return Search<4>(game, goal, options).Run();
+    }
+    return Search<0>(game, goal, options).Run();
+}
+
+Result Solve(const Sokoban& game, const Options& options) {
+    return RunSearch(game, nullptr, options);
+}
+
+Incremental::Incremental(const Sokoban& from, const Options& solverOptions)
+    : game(from.Snapshot()), options(solverOptions) {
+    switch (game.GetAnalysis().boardWords) {
+    case 1:  search = make_unique<Search<1>>(game, nullptr, options); break;
+    case 2:  search = make_unique<Search<2>>(game, nullptr, options); break;
+    case 4:  search = make_unique<Search<4>>(game, nullptr, options); break;
+    default: search = make_unique<Search<0>>(game, nullptr, options); break;
+    }
+}
+
+Incremental::~Incremental() = default;
+
+bool Incremental::Step(int64_t nodes) {
+    done = done || search->Advance(result, nodes);
+    return done;
+}
+
+Result SolveBetween(const Sokoban& from, const Sokoban& to, const Options& options) {
+    return RunSearch(from, &to, options);
+}
+
+int SolveAll(Sokoban& game, const Options& options) {
+    int unsolved = 0;
+    while (true) {
+        auto result = Solve(game, options);
+        cout << "level " << game.GetCurLevel() << " " << game.GetCurLevelName() << ": ";
+        if (result.solved)
+            cout << result.moves << " moves, " << result.pushes << " pushes, " << result.nodesExpanded << " nodes, " << result.lurd << endl;
+        else
+            cout << "unsolved, " << result.nodesExpanded << " nodes" << endl;
+        unsolved += !result.solved;
+        if (game.IsLastLevel())
+            break;
+        game.NextLevel();
+    }
+    return unsolved;
+}
+
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "game.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <cstdint>
+
+// A* over box configurations.
+//
+// A search node is a position after a push: the (sorted) box cells plus the
+// player. When optimizing pushes, the player is represented by the smallest
+// cell of their reachable region, and walks in between pushes are free and
+// only reconstructed at the end. When optimizing moves, the player is the
+// exact cell, and a push costs the walk to it plus one.
+//
+// With a memory budget, it runs IDA* over a fixed size transposition table
+// instead, on as many threads as asked for: slower, but it never runs out of memory.
+namespace GameSolver {
+
+enum class Metric { PUSHES, MOVES };
+
+struct Options {
+    Metric  metric    = Metric::PUSHES;
+    int64_t maxNodes  = 4'000'000;  // A*: nodes kept, IDA*: nodes expanded.
+    // Only look for solutions costing at most this much (in `metric`).
+    int32_t maxCost   = INT32_MAX;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    // Give up as soon as this turns true, e.g., when another thread wants a different search.
+    const std::atomic<bool>* cancel = nullptr;
+    // Bytes of transposition table, 0 to keep every node (A*, much faster while it fits).
+    size_t  memoryBudget = 0;
+    // Threads sharing the transposition table, if any.
+    int     numThreads   = 1;
+    // Expand tunnel and goal room macro pushes (see LevelAnalysis).
+    // Much smaller trees, but the result is no longer push-optimal, so
+    // callers that only need some solution (hints) opt in.
+    // Ignored unless solving for pushes towards the level's targets.
+    bool    useMacros = false;
+    // When the player is fenced off a region by boxes that can only be pushed
+    // into it, and all of those pushes are possible now (a PI-corral), only
+    // make those pushes: the region has to be opened first anyway. A corral
+    // whose boxes can't reach targets even with every other box gone is a
+    // deadlock. Solutions stay push-optimal.
+    // Ignored unless solving for pushes towards the level's targets.
+    bool    usePiCorrals = true;
+};
+
+struct Result {
+    bool        solved        = false;
+    std::string lurd;          // upper case letters are pushes.
+    int32_t     pushes        = 0;
+    int32_t     moves         = 0;
+    int64_t     nodesExpanded = 0;
+};
+
+Result Solve(const Sokoban& game, const Options& options = {});
+
+struct SearchSteps;
+
+// Solve() a slice at a time, for a caller that can neither block nor use
+// threads, like the web build's frame loop. Always A*: memoryBudget and
+// numThreads are ignored.
+class Incremental {
+public:
+    Incremental(const Sokoban& game, const Options& options = {});
+    ~Incremental();
+    Incremental(const Incremental&) = delete;
+    Incremental& operator=(const Incremental&) = delete;
+
+    // Expand up to `nodes` more nodes. Return true once the search is over,
+    // and GetResult() is final.
+    bool Step(int64_t nodes);
+    const Result& GetResult() const { return result; }
+
+private:
+    Sokoban                      game;  // a snapshot, searched in place.
+    Options                      options;
+    Result                       result;
+    bool                         done = false;
+    std::unique_ptr<SearchSteps> search;
+};
+
+// Find a path from `from` to exactly `to` (boxes and player), both on the same level.
+Result SolveBetween(const Sokoban& from, const Sokoban& to, const Options& options = {});
+
+// Solve every level of `game`, print one line per level. Return the number of unsolved levels.
+int SolveAll(Sokoban& game, const Options& options = {});
+
+}
@@ -0,0 +1,100 @@
+#include "game_stats.hpp"
+
+#include <cstdio>
+
+using namespace std;
+
+namespace GameStats {
+
+// Level names come from level files: escape them. Prometheus label values only
+// know \\, \" and \n, anything else goes as is; JSON needs all control characters escaped.
+static void AppendQuoted(string& out, const string& s, Format format) {
+    out += '"';
+    for (unsigned char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (c == '\n') {
+            out += "\\n";
+        } else if (c < 0x20 && format == Format::JSON_LINES) {
+            char hex[8];
+            snprintf(hex, sizeof(hex), "\\u%04x", c);
+            out += hex;
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+static void AppendNumber(string& out, double value) {
+    char number[32];
+    snprintf(number, sizeof(number), "%.15g", value);
+    out += number;
+}
+
+static void WriteJsonLines(const Sokoban& game, string& out) {
+    for (int level = 0; level < game.GetNumLevels(); level++) {
+        auto s = game.GetLevelStats(level);
+        out += "{\"level\":";
+        out += to_string(level);
+        out += ",\"name\":";
+        AppendQuoted(out, game.GetLevelName(level), Format::JSON_LINES);
+        out += ",\"moves\":"       + to_string(s.moves);
+        out += ",\"pushes\":"      + to_string(s.pushes);
+        out += ",\"undos\":"       + to_string(s.undos);
+        out += ",\"restarts\":"    + to_string(s.restarts);
+        out += ",\"completions\":" + to_string(s.completions);
+        out += ",\"seconds\":";
+        AppendNumber(out, s.seconds);
+        out += "}\n";
+    }
+}
+
+static void WritePrometheus(const Sokoban& game, string& out) {
+    struct Metric {
+        const char* name;
+        const char* help;
+        double (*get)(const Sokoban::LevelStats&);
+    };
+    static constexpr Metric METRICS[] = {
+        {"sokoban_moves_total",       "Player moves, pushes included.", [](auto& s) -> double { return s.moves;       }},
+        {"sokoban_pushes_total",      "Box pushes.",                    [](auto& s) -> double { return s.pushes;      }},
+        {"sokoban_undos_total",       "Pushes taken back.",             [](auto& s) -> double { return s.undos;       }},
+        {"sokoban_restarts_total",    "Level restarts.",                [](auto& s) -> double { return s.restarts;    }},
+        {"sokoban_completions_total", "Times the level was solved.",    [](auto& s) -> double { return s.completions; }},
+        {"sokoban_seconds_total",     "Time played on the level.",      [](auto& s) -> double { return s.seconds;     }},
+    };
+    for (auto& metric : METRICS) {
+        out += "# HELP ";
+        out += metric.name;
+        out += ' ';
+        out += metric.help;
+        out += "\n# TYPE ";
+        out += metric.name;
+        out += " counter\n";
+        for (int level = 0; level < game.GetNumLevels(); level++) {
+            out += metric.name;
+            out += "{level=\"" + to_string(level) + "\",name=";
+            AppendQuoted(out, game.GetLevelName(level), Format::PROMETHEUS);
+            out += "} ";
+            AppendNumber(out, metric.get(game.GetLevelStats(level)));
+            out += '\n';
+        }
+    }
+}
+
+void Write(const Sokoban& game, Format format, string& out) {
+    out.clear();
+    switch (format) {
+        case Format::JSON_LINES: WriteJsonLines (game, out); break;
+        case Format::PROMETHEUS: WritePrometheus(game, out); break;
+    }
+}
+
+void Exporter::Flush(const Sokoban& game) {
+    Write(game, format, text);
+    out.Submit(text.data(), text.size());
+}
+
+}
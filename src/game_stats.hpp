@@ -0,0 +1,38 @@
+#pragma once
+
+#include "game.hpp"
+#include "game_file_writer.hpp"
+
+#include <string>
+
+// Export Sokoban::LevelStats of every level, for level designers to see
+// where players get stuck.
+//
+//   JSON_LINES: one object per level,
+//     {"level":0,"name":"...","moves":12,"pushes":3,"undos":0,"restarts":1,"completions":1,"seconds":20.5}
+//   PROMETHEUS: the text exposition format, one sample per level and counter,
+//     sokoban_moves_total{level="0",name="..."} 12
+//
+// The counters are kept by the game itself; formatting them is done on the
+// main loop, every few seconds at most and once on exit, and the file is
+// written by a BackgroundFileWriter.
+namespace GameStats {
+
+enum class Format { JSON_LINES, PROMETHEUS };
+
+// Replace `out` with the stats of all levels of `game`.
+void Write(const Sokoban& game, Format format, std::string& out);
+
+class Exporter {
+public:
+    Exporter(std::string file, Format format) : format(format), out(std::move(file)) {}
+
+    void Flush(const Sokoban& game);
+
+private:
+    Format               format;
+    std::string          text;  // reused, doesn't allocate once warm.
+    BackgroundFileWriter out;
+};
+
+}
@@ -0,0 +1,69 @@
+#include "game_transposition.hpp"
+
+#include <algorithm>
+
+using namespace std;
+
+TranspositionTable::TranspositionTable(size_t bytes, int32_t numLiveCells)
+    : bitsetWords((numLiveCells + 63) / 64),
+      slotWords(4 + bitsetWords),
+      numSlots(max<size_t>(bytes / (slotWords * sizeof(uint64_t)), PROBES)),
+      table(new atomic<uint64_t>[numSlots * slotWords]()) {
+}
+
+TranspositionTable::Visited TranspositionTable::Visit(uint64_t hash, const uint64_t* boxBits, int32_t player, int32_t g, int32_t bound) {
+    const uint64_t costWord   = (static_cast<uint64_t>(static_cast<uint32_t>(g)) << 32) | static_cast<uint32_t>(bound);
+    const uint64_t playerWord = static_cast<uint32_t>(player);
+    uint64_t keyXor = hash ^ playerWord;
+    for (int32_t w = 0; w < bitsetWords; w++)
+        keyXor ^= boxBits[w];
+
+    auto Store = [&](atomic<uint64_t>* slot, bool keyToo) {
+        slot[2].store(costWord, memory_order_relaxed);
+        if (keyToo) {
+            slot[1].store(hash, memory_order_relaxed);
+            slot[3].store(playerWord, memory_order_relaxed);
+            for (int32_t w = 0; w < bitsetWords; w++)
+                slot[4 + w].store(boxBits[w], memory_order_relaxed);
+        }
+        slot[0].store(costWord ^ keyXor, memory_order_release);
+    };
+
+    const size_t first = hash % numSlots;
+    atomic<uint64_t>* victim = nullptr;
+    uint64_t victimScore = UINT64_MAX;
+    for (int p = 0; p < PROBES; p++) {
+        auto* slot  = Slot((first + p) % numSlots);
+        auto  check = slot[0].load(memory_order_acquire);
+        auto  h     = slot[1].load(memory_order_relaxed);
+        auto  cost  = slot[2].load(memory_order_relaxed);
+        auto  pl    = slot[3].load(memory_order_relaxed);
+        bool  same  = h == hash && pl == playerWord;
+        auto  x     = h ^ cost ^ pl;
+        for (int32_t w = 0; w < bitsetWords; w++) {
+            auto bits = slot[4 + w].load(memory_order_relaxed);
+            same &= bits == boxBits[w];
+            x    ^= bits;
+        }
+        // an all-zero slot is empty; any other slot checks against its own words.
+        bool valid    = check != 0 && check == x;
+        auto oldG     = static_cast<uint32_t>(cost >> 32);
+        auto oldBound = static_cast<uint32_t>(cost);
+        if (valid && same) {
+            if (oldG < static_cast<uint32_t>(g))
+                return VISIT_CHEAPER;
+            if (oldG == static_cast<uint32_t>(g) && oldBound == static_cast<uint32_t>(bound))
+                return VISIT_SAME;
+            Store(slot, false);
+            return VISIT_NEW;
+        }
+        // an empty or torn slot is the best victim, then the oldest bound, then the largest g.
+        uint64_t score = !valid ? 0 : (static_cast<uint64_t>(oldBound) << 32) | (UINT32_MAX - oldG);
+        if (score < victimScore) {
+            victimScore = score;
+            victim      = slot;
+        }
+    }
+    Store(victim, true);
+    return VISIT_NEW;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+// Fixed size, lock-free transposition table for memory-bounded searches.
+//
+// An entry holds a compact position: one bit per live cell (a floor cell a
+// box may stand on) plus the player cell, and the cost and search bound it was
+// last visited with. Slots are probed linearly within a small window; when
+// that window is full, the entry of the oldest bound (aging), then the one
+// closest to the leaves (depth-preferred), is replaced.
+//
+// Many threads may share a table. Every word is an atomic, and the first word
+// of a slot is the xor of all its other words, the entry's own hash among
+// them, so a read that races with a write is detected as garbage and treated
+// as an empty slot, no lock needed.
+class TranspositionTable {
+public:
+    TranspositionTable(size_t bytes, int32_t numLiveCells);
+
+    int32_t BitsetWords() const { return bitsetWords; }
+    size_t  NumSlots()    const { return numSlots;    }
+
+    enum Visited {
+        VISIT_NEW,      // recorded, search it.
+        VISIT_CHEAPER,  // already reached at a lower cost, skip it.
+        VISIT_SAME,     // already reached at this cost under this bound, skip it.
+    };
+    Visited Visit(uint64_t hash, const uint64_t* boxBits, int32_t player, int32_t g, int32_t bound);
+
+private:
+    static constexpr int PROBES = 4;
+
+    std::atomic<uint64_t>* Slot(size_t i) { return &table[i * slotWords]; }
+
+    int32_t bitsetWords;
+    int32_t slotWords;   // check, hash, (g, bound), player, bitset...
+    size_t  numSlots;
+    std::unique_ptr<std::atomic<uint64_t>[]> table;
+};
@@ -0,0 +1,193 @@
+#include "game_vec.hpp"
+#include "game_analysis.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+// Below this many games per thread, waking the pool costs more than it saves.
+static constexpr int32_t MIN_ENVS_PER_THREAD = 512;
+
+static uint64_t SplitMix64(uint64_t& state) {
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+void VecSokoban::PackShape(const Sokoban& game, int32_t& rows, int32_t& cols) {
+    rows = cols = 0;
+    for (int i = 0; i < game.GetNumLevels(); i++) {
+        rows = max(rows, game.GetLevel(i).Rows());
+        cols = max(cols, game.GetLevel(i).Cols());
+    }
+}
+
+size_t VecSokoban::ObservationBytes(const Sokoban& game, const Options& options) {
+    int32_t rows, cols;
+    PackShape(game, rows, cols);
+    return static_cast<size_t>(max(options.numEnvs, 1)) * rows * cols;
+}
+
+VecSokoban::VecSokoban(const Sokoban& game, const Options& options, uint8_t* observations)
+    : numEnvs(max(options.numEnvs, 1)), maxSteps(options.maxSteps) {
+    PackShape(game, rows, cols);
+    delta[DIR_LEFT]  = -1;
+    delta[DIR_UP]    = -cols;
+    delta[DIR_RIGHT] = 1;
+    delta[DIR_DOWN]  = cols;
+
+    Sokoban scratch;
+    levels.resize(game.GetNumLevels());
+    for (int i = 0; i < game.GetNumLevels(); i++) {
+        scratch.LoadLevel(game.GetLevel(i));
+        const auto& state = scratch.GetState();
+        const auto& a     = scratch.GetAnalysis();
+        auto& l = levels[i];
+        l.tiles.assign(rows * cols, TILE_NULL);
+        l.dead.assign(rows * cols, 0);
+        l.numBoxes = l.numBoxesOnTarget = 0;
+        for (int32_t r = 0; r < a.rows; r++) {
+            for (int32_t c = 0; c < a.cols; c++) {
+                auto tile = state[r][c];
+                auto cell = r * cols + c;
+                if (tile & TILE_PLAYER) {
+                    tile     = static_cast<TileType>(tile & ~3);
+                    l.player = cell;
+                }
+                l.tiles[cell]       = tile;
+                l.dead[cell]        = a.dead[a.Cell({r, c})];
+                l.numBoxes         += (tile & TILE_BOX) ? 1 : 0;
+                l.numBoxesOnTarget += (tile & TILE_BOX) && (tile & TILE_TARGET);
+            }
+        }
+    }
+
+    if (!observations) {
+        ownTiles.resize(static_cast<size_t>(numEnvs) * rows * cols);
+        observations = ownTiles.data();
+    }
+    tiles = observations;
+    player.resize(numEnvs);
+    level.resize(numEnvs);
+    numBoxesOnTarget.resize(numEnvs);
+    steps.resize(numEnvs);
+    rng.resize(numEnvs);
+    for (int32_t env = 0; env < numEnvs; env++) {
+        uint64_t seed = options.seed ^ (0x5ce11aULL * (env + 1));
+        rng[env] = SplitMix64(seed);
+    }
+    Reset();
+
+#if !defined(PLATFORM_WEB)
+    int numThreads = options.numThreads > 0 ? options.numThreads
+                                            : max(1, static_cast<int>(thread::hardware_concurrency()));
+    numParts = max(1, min(numThreads, numEnvs / MIN_ENVS_PER_THREAD));
+    for (int i = 1; i < numParts; i++)
+        workers.emplace_back(&VecSokoban::Run, this, i);
+#endif
+}
+
+VecSokoban::~VecSokoban() {
+    {
+        lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wakeUp.notify_all();
+    for (auto& t : workers)
+        t.join();
+}
+
+void VecSokoban::Reset() {
+    for (int32_t env = 0; env < numEnvs; env++)
+        ResetEnv(env);
+}
+
+void VecSokoban::ResetEnv(int32_t env) {
+    level[env] = static_cast<int32_t>(SplitMix64(rng[env]) % levels.size());
+    const auto& l = levels[level[env]];
+    memcpy(tiles + static_cast<size_t>(env) * rows * cols, l.tiles.data(), l.tiles.size());
+    player[env]           = l.player;
+    numBoxesOnTarget[env] = l.numBoxesOnTarget;
+    steps[env]            = 0;
+}
+
+// IsFrozenSquare, on the board tensor.
+bool VecSokoban::IsFrozen(const uint8_t* board, int32_t box) const {
+    return IsFrozenSquare(box, cols, [board](int32_t x) { return (board[x] & TILE_BLOCKED) != 0; },
+                          [board](int32_t x) { return (board[x] & TILE_BOX) != 0; },
+                          [board](int32_t x) { return (board[x] & TILE_TARGET) != 0; });
+}
+
+void VecSokoban::StepRange(int32_t begin, int32_t end) {
+    const size_t cells = static_cast<size_t>(rows) * cols;
+    for (int32_t env = begin; env < end; env++) {
+        auto*       board = tiles + env * cells;
+        const auto& l     = levels[level[env]];
+        auto d     = delta[actions[env] % NUM_ACTIONS];
+        auto p     = player[env];
+        auto next  = p + d;
+        auto reward   = REWARD_STEP;
+        bool deadlock = false;
+        if (board[next] & TILE_BOX) {
+            auto to = next + d;
+            if (!(board[to] & TILE_SPACE_MASK)) {
+                board[next] &= ~TILE_BOX;
+                board[to]   |= TILE_BOX;
+                auto on = ((board[to] & TILE_TARGET) ? 1 : 0) - ((board[next] & TILE_TARGET) ? 1 : 0);
+                numBoxesOnTarget[env] += on;
+                reward  += on > 0 ? REWARD_BOX_ON : on < 0 ? REWARD_BOX_OFF : 0;
+                deadlock = l.dead[to] || IsFrozen(board, to);
+            }
+        }
+        if (!(board[next] & TILE_SPACE_MASK)) {
+            board[p]    &= ~TILE_PLAYER;
+            board[next] |= TILE_PLAYER;
+            player[env]  = next;
+        }
+        bool solved = numBoxesOnTarget[env] == l.numBoxes;
+        bool done   = solved || deadlock || ++steps[env] >= maxSteps;
+        rewards[env] = reward + (solved ? REWARD_SOLVED : 0);
+        dones[env]   = done;
+        if (done)
+            ResetEnv(env);
+    }
+}
+
+void VecSokoban::Step(const uint8_t* actions, float* rewards, uint8_t* dones) {
+    this->actions = actions;
+    this->rewards = rewards;
+    this->dones   = dones;
+    if (numParts > 1) {
+        {
+            lock_guard<std::mutex> lock(mutex);
+            generation++;
+            working = numParts - 1;
+        }
+        wakeUp.notify_all();
+    }
+    StepRange(0, numEnvs / numParts);
+    if (numParts > 1) {
+        unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [this] { return working == 0; });
+    }
+}
+
+void VecSokoban::Run(int id) {
+    uint64_t seen = 0;
+    while (true) {
+        {
+            unique_lock<std::mutex> lock(mutex);
+            wakeUp.wait(lock, [this, seen] { return quit || generation != seen; });
+            if (quit)
+                return;
+            seen = generation;
+        }
+        StepRange(static_cast<int32_t>(int64_t {numEnvs} * id / numParts),
+                  static_cast<int32_t>(int64_t {numEnvs} * (id + 1) / numParts));
+        lock_guard<std::mutex> lock(mutex);
+        if (--working == 0)
+            finished.notify_one();
+    }
+}
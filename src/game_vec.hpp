@@ -0,0 +1,110 @@
+#pragma once
+
+#include "game.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstdint>
+
+// Many independent games stepped together, for training agents.
+//
+// The boards are one contiguous tensor of NumEnvs() x Rows() x Cols() bytes,
+// a TileType per cell (player facing left out), every level of the pack
+// padded with TILE_NULL to the largest one. That tensor is the game state
+// itself: hand in your own buffer and Step() updates it in place, so the
+// observations are never copied. Everything else is one array per field.
+//
+// An episode ends when the level is solved, when a push deadlocks a box
+// (onto a dead square, or into a frozen 2x2 block), or after
+// Options::maxSteps steps. Step() then reports it done and starts the next
+// episode on a random level right away: the observation is the new board.
+//
+// Step() splits the games across a pool of threads that lives as long as
+// the VecSokoban. Each game has its own random generator, so a run is
+// reproducible whatever the number of threads.
+class VecSokoban {
+public:
+    // Actions are Dir values: 0 left, 1 up, 2 right, 3 down.
+    static constexpr int32_t NUM_ACTIONS = 4;
+
+    static constexpr float REWARD_STEP       = -0.1f;
+    static constexpr float REWARD_BOX_ON     =  1.0f;   // a box pushed onto a target,
+    static constexpr float REWARD_BOX_OFF    = -1.0f;   // or off one.
+    static constexpr float REWARD_SOLVED     = 10.0f;
+
+    struct Options {
+        int32_t  numEnvs    = 1024;
+        int32_t  maxSteps   = 200;   // per episode.
+        int      numThreads = 0;     // 0: one per core.
+        uint64_t seed       = 1;
+    };
+
+    // The levels of `game`'s level pack. `observations`, if not null, must
+    // hold ObservationBytes(game, options) bytes and outlive the VecSokoban.
+    VecSokoban(const Sokoban& game, const Options& options, uint8_t* observations = nullptr);
+    // Size of the board tensor, NumEnvs() * Rows() * Cols(), before there is a VecSokoban.
+    static size_t ObservationBytes(const Sokoban& game, const Options& options);
+    ~VecSokoban();
+    VecSokoban(const VecSokoban&) = delete;
+    VecSokoban& operator=(const VecSokoban&) = delete;
+
+    int32_t NumEnvs() const { return numEnvs; }
+    int32_t Rows()    const { return rows; }
+    int32_t Cols()    const { return cols; }
+    const uint8_t* Observations() const { return tiles; }
+    // Level (index in the pack) the game `env` is playing.
+    int32_t GetLevel(int32_t env) const { return level[env]; }
+
+    // Start every game on a random level.
+    void Reset();
+    // Play actions[env] in every game. rewards and dones hold NumEnvs() each.
+    void Step(const uint8_t* actions, float* rewards, uint8_t* dones);
+
+private:
+    struct Level {
+        std::vector<uint8_t> tiles;  // Rows() x Cols(), padded.
+        std::vector<uint8_t> dead;   // a box here can never reach a target.
+        int32_t              player;
+        int32_t              numBoxes;
+        int32_t              numBoxesOnTarget;
+    };
+
+    // Rows and cols of the largest level of the pack.
+    static void PackShape(const Sokoban& game, int32_t& rows, int32_t& cols);
+    void    ResetEnv(int32_t env);
+    bool    IsFrozen(const uint8_t* board, int32_t box) const;
+    void    StepRange(int32_t begin, int32_t end);
+    void    Run(int id);
+
+    int32_t              numEnvs;
+    int32_t              rows = 0;
+    int32_t              cols = 0;
+    int32_t              maxSteps;
+    int32_t              delta[4];
+    std::vector<Level>   levels;
+
+    // one entry per game.
+    std::vector<uint8_t>  ownTiles;  // the board tensor, unless the caller gave one.
+    uint8_t*              tiles;
+    std::vector<int32_t>  player;
+    std::vector<int32_t>  level;
+    std::vector<int32_t>  numBoxesOnTarget;
+    std::vector<int32_t>  steps;
+    std::vector<uint64_t> rng;
+
+    // the step being played, for the pool.
+    const uint8_t* actions = nullptr;
+    float*         rewards = nullptr;
+    uint8_t*       dones   = nullptr;
+
+    std::mutex               mutex;     // guards generation, working and quit.
+    std::condition_variable  wakeUp;
+    std::condition_variable  finished;
+    uint64_t                 generation = 0;
+    int                      working    = 0;
+    int                      numParts   = 1;  // of the games: one for this thread, one per worker.
+    bool                     quit       = false;
+    std::vector<std::thread> workers;
+};
@@ -4,10 +4,19 @@
 
 #include "game.hpp"
 #include "game_gui.hpp"
+#include "game_generator.hpp"
+#include "game_optimizer.hpp"
+#include "game_session.hpp"
+#include "game_solver.hpp"
+#include "game_stats.hpp"
 
 #include <CLI/CLI.hpp>
 
+#include <algorithm>
 #include <cassert>
+#include <iostream>
+#include <memory>
+#include <thread>
 
 using namespace GameGui;
 using namespace std;
@@ -16,35 +25,142 @@ int main(int argc, char** argv) {
 
     CLI::App app{"Sokoban"};
     int FPS = 60;
+    // Offline tools: solve, optimize and generate levels, then exit.
+    string levelFile;
+    string solutionFile;
+    string generatedFile;
+    string metric = "pushes";
+    size_t memoryMB = 0;
+    int    numThreads = 0;
+    GameOptimizer::Options optimizerOptions;
+    GameGenerator::Options generatorOptions;
+    [[maybe_unused]] auto* _3 = app.add_option("--level", levelFile, "load level from txt file");
+    auto* option_solve        = app.add_flag("--solve", "solve all levels, print solutions (optimal in --metric unless --macros) and exit");
+    [[maybe_unused]] auto* _4 = app.add_flag("--macros", "solve with tunnel/goal room macros: faster, but not push-optimal")
+                                        ->needs(option_solve);
+    [[maybe_unused]] auto* _17 = app.add_flag("--no-corrals", "solve without PI-corral pruning")
+                                        ->needs(option_solve);
+    auto* option_optimize     = app.add_option("--optimize", solutionFile, "shorten the solutions in file (one line per level) and exit")
+                                        ->excludes(option_solve);
+    [[maybe_unused]] auto* _5 = app.add_option("--metric", metric, "what --solve/--optimize minimize")
+                                        ->check(CLI::IsMember({"moves", "pushes"}));
+    [[maybe_unused]] auto* _6 = app.add_option("--time-budget", optimizerOptions.timeBudget, "seconds per solution")
+                                        ->needs(option_optimize);
+    [[maybe_unused]] auto* _7 = app.add_option("--threads", numThreads, "for --generate, --optimize and --solve with --memory-mb, 0: one per core");
+    [[maybe_unused]] auto* _8 = app.add_option("--memory-mb", memoryMB, "solve within this much memory (IDA*), 0: A*")
+                                        ->needs(option_solve);
+    auto* option_generate     = app.add_option("--generate", generatedFile, "write random levels to file and exit")
+                                        ->excludes(option_solve)
+                                        ->excludes(option_optimize);
+    [[maybe_unused]] auto* _9 = app.add_option("--count", generatorOptions.count, "levels to generate")
+                                        ->needs(option_generate);
+    [[maybe_unused]] auto* _10 = app.add_option("--boxes", generatorOptions.numBoxes, "boxes per generated level")
+                                        ->needs(option_generate);
+    [[maybe_unused]] auto* _11 = app.add_option("--min-score", generatorOptions.minScore, "keep generated levels at least this hard")
+                                        ->needs(option_generate);
+    [[maybe_unused]] auto* _18 = app.add_option("--max-candidates", generatorOptions.maxCandidates, "give up after trying this many levels, exit 1 with the ones kept")
+                                        ->needs(option_generate);
 #if defined(DEBUG) || defined(COVERAGE)
+    // testing only, excludes() applies both ways.
     string raylibEventFile;
-    string levelFile;
-    auto* option_record       = app.add_option("--record", raylibEventFile, "record input event");
+    auto* option_record       = app.add_option("--record", raylibEventFile, "record input event")
+                                        ->excludes(option_solve)
+                                        ->excludes(option_optimize)
+                                        ->excludes(option_generate);
     auto* option_replay       = app.add_option("--replay", raylibEventFile, "replay events from file")
-                                        ->excludes(option_record);
+                                        ->excludes(option_record)
+                                        ->excludes(option_solve)
+                                        ->excludes(option_optimize)
+                                        ->excludes(option_generate);
     [[maybe_unused]] auto* _1 = app.add_flag("--exit", "exit after rending first frame")
                                         ->excludes(option_record)
                                         ->excludes(option_replay);
-    [[maybe_unused]] auto* _3 = app.add_option("--level", levelFile, "load level from txt file");
 #endif
     [[maybe_unused]] auto* _2 = app.add_option("--fps",    FPS, "Set FPS (intended for testing only)")
                                         ->default_val(60);
+    bool showLatency = false;
+    bool noIdle      = false;
+    string sessionFile = "sokoban.session";
+    [[maybe_unused]] auto* _14 = app.add_option("--session", sessionFile, "save the game here, and resume from it on start")
+                                        ->default_val("sokoban.session");
+    [[maybe_unused]] auto* _15 = app.add_flag("--no-session", "start afresh and don't save");
+    string statsFile;
+    string statsFormat = "json";
+    auto* option_stats         = app.add_option("--stats", statsFile, "keep per-level play statistics in file");
+    [[maybe_unused]] auto* _16 = app.add_option("--stats-format", statsFormat, "json (lines) or prometheus (text format)")
+                                        ->check(CLI::IsMember({"json", "prometheus"}))
+                                        ->needs(option_stats);
+    [[maybe_unused]] auto* _13 = app.add_flag("--no-idle", noIdle, "redraw every frame, even when nothing changes");
+    [[maybe_unused]] auto* _12 = app.add_flag("--show-latency", showLatency, "show poll-to-present input latency, print it on exit");
 
     CLI11_PARSE(app, argc, argv);
 
+    Sokoban       game;
+    game.LoadDefaultLevels();
+    if (app.count("--generate")) {
+        generatorOptions.numThreads = numThreads;
+        return GameGenerator::GenerateAll(generatedFile.c_str(), generatorOptions) == generatorOptions.count ? 0 : 1;
+    }
+    if (app.count("--level")) {
+        game.LoadLevels(levelFile.c_str());
+    }
+    auto solverMetric = metric == "moves" ? GameSolver::Metric::MOVES : GameSolver::Metric::PUSHES;
+    if (app.count("--solve")) {
+        if (app.count("--threads") && !memoryMB)
+            return app.exit(CLI::ValidationError("--threads", "--solve runs A* on one thread, add --memory-mb for IDA*"));
+        GameSolver::Options options;
+        options.metric       = solverMetric;
+        options.useMacros    = app.count("--macros") > 0;
+        options.usePiCorrals = !app.count("--no-corrals");
+        if (memoryMB) {
+            options.memoryBudget = memoryMB << 20;
+            options.maxNodes     = INT64_MAX;
+            options.numThreads   = numThreads ? numThreads : static_cast<int>(max(1u, thread::hardware_concurrency()));
+        }
+        return GameSolver::SolveAll(game, options);
+    }
+    if (app.count("--optimize")) {
+        optimizerOptions.metric     = solverMetric;
+        optimizerOptions.numThreads = numThreads;
+        return GameOptimizer::OptimizeAll(game, solutionFile.c_str(), optimizerOptions);
+    }
+
     // Initialization
     //--------------------------------------------------------------------------------------
     raylib::Window window(800, 600, "sokoban");
 
     GuiLoadStyle("assets/styles/cyber/cyber.rgs");
     GuiSetStyle(DEFAULT, TEXT_SIZE, 40);
-    Sokoban       game;
     GameResources gameResources;
-    game.LoadDefaultLevels();
 
     GameGui::Init(&gameResources);
     SetTargetFPS(FPS);              // Set FPS
     SetExitKey(KEY_NULL);           // Disable quit-on-ESC
+
+    // Resume where the last session left off, before the first frame.
+    bool useSession = !app.count("--no-session");
+#if defined(PLATFORM_WEB)
+    useSession = false; // nowhere to keep it.
+#endif
+#if defined(DEBUG) || defined(COVERAGE)
+    // replays expect a fresh start.
+    useSession &= !app.count("--replay") && !app.count("--record") && !app.count("--exit");
+#endif
+    unique_ptr<GameSession::Writer> session;
+    if (useSession) {
+        uint8_t scene;
+        // resume paused, and on the pause scene too if the saved one is unknown.
+        if (GameSession::Load(sessionFile, game, scene))
+            GameGui::SetGameScene(scene == GameGui::MAIN_GAME_SCENE || scene > GameGui::LEVEL_FINISHED_SCENE
+                                      ? GameGui::ESC_SCENE : static_cast<GameScene>(scene), game);
+        session = make_unique<GameSession::Writer>(sessionFile);
+    }
+    unique_ptr<GameStats::Exporter> stats;
+#if !defined(PLATFORM_WEB)
+    if (app.count("--stats"))
+        stats = make_unique<GameStats::Exporter>(statsFile, statsFormat == "prometheus" ? GameStats::Format::PROMETHEUS
+                                                                                        : GameStats::Format::JSON_LINES);
+#endif
     //---------------------------------------------------------------------------------------
 
 #if defined(DEBUG) || defined(COVERAGE)
@@ -57,9 +173,6 @@ int main(int argc, char** argv) {
     if (app.count("--replay")) {
         raylibEventList = LoadAutomationEventList(raylibEventFile.c_str());
     }
-    if (app.count("--level")) {
-        game.LoadLevels(levelFile.c_str());
-    }
 #endif
 #if defined(DEBUG)
     if (app.count("--record")) {
@@ -74,27 +187,82 @@ int main(int argc, char** argv) {
 #endif
 
     // Main game loop
-    bool shouldClose = false;
+    bool           shouldClose = false;
+    GameEventQueue gameEvents;
+    LatencyMeter   latency;
+    // raylib polls input at the end of EndDrawing() and in WaitForInput(),
+    // events are stamped with that rather than with when they're cooked.
+    double polledAt = GetTime();
+    // Idle mode: don't redraw an unchanged screen, sleep until there is input instead.
+    bool idle = !noIdle;
+#if defined(DEBUG) || defined(COVERAGE)
+    // replayed events don't wake up a sleeping loop.
+    idle &= !app.count("--replay") && !app.count("--record") && !app.count("--exit");
+#endif
     while (!shouldClose) {
         //----------------------------------------------------------------------------------
         // Update
         //----------------------------------------------------------------------------------
-        Sokoban::Pos pos = GameGui::PixelToPos(GetMousePosition());
-        auto [gameEvents, guiEvent] = GameGui::CookInputEvent(game);
-        game.ProcessEvent(gameEvents, pos);
+        game.SetClockRunning(GameGui::GetGameScene() == GameGui::MAIN_GAME_SCENE);
+        auto guiEvent = GameGui::CookInputEvent(game, gameEvents, polledAt);
+        bool changed  = game.ProcessEvent(gameEvents);
+        if (changed)
+            GameGui::Invalidate();
 
         //----------------------------------------------------------------------------------
         // Draw
         //----------------------------------------------------------------------------------
-        BeginDrawing();
-        window.ClearBackground(LIGHTGRAY);
-        auto event = GameGui::Draw(window, game);
-        EndDrawing();
+        auto event = GuiEvent::EVENT_NULL;
+        if (!idle || GameGui::ShouldDraw()) {
+            BeginDrawing();
+            window.ClearBackground(LIGHTGRAY);
+            event = GameGui::Draw(window, game);
+            if (showLatency)
+                GameGui::DrawLatency(latency);
+            EndDrawing();
+        } else {
+            GameGui::WaitForInput();
+            changed = false;
+        }
+        // presented, and input polled for the next frame, either way.
+        double now = GetTime();
+
+        // this frame shows the effect of its events, if any.
+        for (TimedGameEvent e; gameEvents.Pop(e); )
+            if (changed)
+                latency.Record(now - e.time);
+        polledAt = now;
 
         shouldClose |= GameGui::ProcessGuiEvent(guiEvent, game);
         shouldClose |= GameGui::ProcessGuiEvent(event,    game);
         shouldClose |= window.ShouldClose(); // window close button
 
+        // Save on any scene change (pause, level finished, ...), on exit,
+        // and every few seconds of play.
+        if (session) {
+            static constexpr double SAVE_EVERY = 10; // seconds
+            static GameScene savedScene   = GameGui::GetGameScene();
+            static uint32_t  savedVersion = game.GetVersion();
+            static double    savedTime    = GetTime();
+            if (GameGui::GetGameScene() != savedScene || shouldClose ||
+                (game.GetVersion() != savedVersion && GetTime() - savedTime > SAVE_EVERY)) {
+                savedScene   = GameGui::GetGameScene();
+                savedVersion = game.GetVersion();
+                savedTime    = GetTime();
+                session->Save(game, savedScene);
+            }
+        }
+        if (stats) {
+            static constexpr double FLUSH_EVERY = 10; // seconds
+            static uint32_t flushedVersion = game.GetVersion();
+            static double   flushedTime    = GetTime();
+            if (game.GetVersion() != flushedVersion && GetTime() - flushedTime > FLUSH_EVERY) {
+                flushedVersion = game.GetVersion();
+                flushedTime    = GetTime();
+                stats->Flush(game);
+            }
+        }
+
         //----------------------------------------------------------------------------------
         // Replay input events
         //----------------------------------------------------------------------------------
@@ -120,6 +288,10 @@ int main(int argc, char** argv) {
 #endif
     }
 
+    // whichever way the loop ended, replays and --exit included.
+    if (stats)
+        stats->Flush(game);
+
     // raylib event record and replay.
 #if defined(DEBUG) || defined(COVERAGE)
     if (app.count("--replay")) {
@@ -132,5 +304,11 @@ int main(int argc, char** argv) {
         ExportAutomationEventList(raylibEventList, raylibEventFile.c_str());
     }
 #endif
+    if (showLatency) {
+        auto s = latency.Summarize();
+        cout << "poll-to-present input latency over the last " << s.count << " of " << latency.Total() << " events: p50 "
+             << s.p50 * 1000 << " ms, p95 " << s.p95 * 1000 << " ms, max " << s.max * 1000 << " ms, "
+             << gameEvents.Dropped() << " dropped" << endl;
+    }
     return 0;
 }
@@ -0,0 +1,57 @@
+# Optimize every solution, then fail unless each result is no longer than
+# its input in the metric, and still solves its level when replayed by a
+# second --optimize run with no time to change anything.
+#
+# cmake -DSOKOBAN=<binary> -DLEVELS=<level file> -DSOLUTIONS=<solution file> -DMETRIC=moves
+#       -DOUTPUT=<scratch file> -P check_optimized.cmake
+cmake_minimum_required(VERSION 3.14)
+set(line "level [0-9]+ [^\n]*: ([0-9]+)/([0-9]+) -> ([0-9]+)/([0-9]+) moves/pushes, ([lurdLURD]+)")
+
+execute_process(COMMAND ${SOKOBAN} --optimize ${SOLUTIONS} --metric ${METRIC} --level ${LEVELS}
+                OUTPUT_VARIABLE output RESULT_VARIABLE result)
+if (NOT result EQUAL 0)
+    message(FATAL_ERROR "--optimize failed (${result}):\n${output}")
+endif()
+file(STRINGS ${SOLUTIONS} inputs)
+string(REGEX MATCHALL "${line}" optimized "${output}")
+list(LENGTH inputs    numInputs)
+list(LENGTH optimized numOptimized)
+if (numInputs EQUAL 0 OR NOT numInputs EQUAL numOptimized)
+    message(FATAL_ERROR "${numInputs} solutions in, ${numOptimized} optimized out:\n${output}")
+endif()
+
+set(lurds "")
+math(EXPR last "${numInputs} - 1")
+foreach (i RANGE ${last})
+    list(GET inputs    ${i} input)
+    list(GET optimized ${i} entry)
+    string(REGEX MATCH "${line}" entry "${entry}")
+    set(before         ${CMAKE_MATCH_1})
+    set(beforePushes   ${CMAKE_MATCH_2})
+    set(reported       ${CMAKE_MATCH_3})
+    set(reportedPushes ${CMAKE_MATCH_4})
+    set(lurd           ${CMAKE_MATCH_5})
+    string(LENGTH "${input}" inputMoves)
+    string(LENGTH "${lurd}"  moves)
+    string(REGEX REPLACE "[lurd]" "" pushed "${lurd}")
+    string(LENGTH "${pushed}" pushes)
+    if (NOT moves EQUAL reported OR NOT pushes EQUAL reportedPushes)
+        message(FATAL_ERROR "solution ${i} is ${moves}/${pushes} moves/pushes, reported ${reported}/${reportedPushes}")
+    endif()
+    if (METRIC STREQUAL "moves" AND (moves GREATER before OR moves GREATER inputMoves))
+        message(FATAL_ERROR "solution ${i} got longer: ${inputMoves} -> ${moves} moves")
+    endif()
+    if (METRIC STREQUAL "pushes" AND pushes GREATER beforePushes)
+        message(FATAL_ERROR "solution ${i} got longer: ${beforePushes} -> ${pushes} pushes")
+    endif()
+    string(APPEND lurds "${lurd}\n")
+endforeach()
+
+# --optimize exits with the number of solutions that don't solve their level.
+file(WRITE ${OUTPUT} "${lurds}")
+execute_process(COMMAND ${SOKOBAN} --optimize ${OUTPUT} --time-budget 0 --level ${LEVELS}
+                OUTPUT_VARIABLE output RESULT_VARIABLE result)
+if (NOT result EQUAL 0)
+    message(FATAL_ERROR "optimized solutions don't all solve their level (${result}):\n${output}")
+endif()
+message(STATUS "${numOptimized} optimized solutions, all valid and no longer")
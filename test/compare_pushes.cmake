@@ -0,0 +1,27 @@
+# Solve every level twice, with and without one solver option, and fail
+# unless both find solutions of the same push counts, level by level.
+# Both runs go without macros (the default), which aren't push-optimal, so
+# the option is checked against the plain A* optimum.
+#
+# cmake -DSOKOBAN=<binary> -DLEVELS=<level file> -DOPTION=--no-corrals -P compare_pushes.cmake
+cmake_minimum_required(VERSION 3.14)
+foreach (run default optioned)
+    if (run STREQUAL "default")
+        set(args --solve --level ${LEVELS})
+    else()
+        set(args --solve ${OPTION} --level ${LEVELS})
+    endif()
+    execute_process(COMMAND ${SOKOBAN} ${args} OUTPUT_VARIABLE output RESULT_VARIABLE result)
+    if (NOT result EQUAL 0)
+        message(FATAL_ERROR "${SOKOBAN} ${args} failed (${result}):\n${output}")
+    endif()
+    string(REGEX MATCHALL "level [0-9]+ [^\n]*: [0-9]+ moves, [0-9]+ pushes" solutions "${output}")
+    string(REGEX REPLACE "[0-9]+ moves, " "" ${run} "${solutions}")
+endforeach()
+if (default STREQUAL "")
+    message(FATAL_ERROR "no solutions found in the output")
+endif()
+if (NOT default STREQUAL optioned)
+    message(FATAL_ERROR "push counts differ\ndefault: ${default}\n${OPTION}: ${optioned}")
+endif()
+message(STATUS "same push counts: ${default}")
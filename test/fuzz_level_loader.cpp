@@ -0,0 +1,39 @@
+// libFuzzer target for the level loader, see SOKOBAN_FUZZ in CMakeLists.txt.
+//
+// Whatever the input, loading must not crash, and whatever loads must be a
+// playable board: invariants hold and every level survives a few moves.
+#include "game.hpp"
+
+#include <sstream>
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    std::istringstream in(std::string(reinterpret_cast<const char*>(data), size));
+    Sokoban game;
+    game.LoadDefaultLevels();
+    if (!game.LoadLevels(in))
+        return 0;
+    while (true) {
+        if (!game.CheckInvariants())
+            abort();
+        // replay the input as moves, too.
+        for (size_t i = 0; i < size && i < 64; i++) {
+            switch (data[i] & 3) {
+            case 0: game.PushWest();  break;
+            case 1: game.PushNorth(); break;
+            case 2: game.PushEast();  break;
+            case 3: game.PushSouth(); break;
+            }
+            if (data[i] & 4)
+                game.Regret();
+        }
+        if (!game.CheckInvariants())
+            abort();
+        if (game.IsLastLevel())
+            break;
+        game.NextLevel();
+    }
+    return 0;
+}
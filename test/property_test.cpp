@@ -0,0 +1,104 @@
+// Random Push/Regret/Click/Restart sequences against the game core,
+// checking after every step:
+//
+//   - Sokoban::CheckInvariants(): one player, box counters match a recount.
+//   - a push followed by Regret() restores the board (player facing aside).
+//   - a step that pushes nothing leaves every box where it was.
+//
+// Every step looks at the whole board, so huge boards get fewer steps.
+//
+// usage: property_test [level file] [steps per level] [seed]
+#include "game.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+
+using namespace std;
+
+// Tiles looked at per level, at most: a million steps on boards up to 1000 tiles.
+static constexpr int64_t MAX_TILES = 1'000'000'000;
+
+// FNV-1a of the board, player facing masked out: Regret() turns the player around.
+static uint64_t BoardHash(const Sokoban& game, bool boxesOnly) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (auto& row : game.GetState()) {
+        for (auto tile : row) {
+            uint8_t t = tile;
+            if (t & TILE_PLAYER)
+                t &= boxesOnly ? ~(TILE_PLAYER | 3) : ~3;
+            hash = (hash ^ t) * 0x100000001b3ULL;
+        }
+    }
+    return hash;
+}
+
+int main(int argc, char** argv) {
+    int64_t  steps = argc > 2 ? atoll(argv[2]) : 1'000'000;
+    uint64_t seed  = argc > 3 ? strtoull(argv[3], nullptr, 10) : 1;
+
+    Sokoban game;
+    game.LoadDefaultLevels();
+    if (argc > 1 && argv[1][0] && !game.LoadLevels(argv[1])) {
+        cout << "cannot load " << argv[1] << endl;
+        return 1;
+    }
+
+    mt19937_64 rng(seed);
+    int64_t total = 0;
+    auto start = chrono::steady_clock::now();
+    while (true) {
+        const int rows = static_cast<int>(game.GetState().size());
+        const int cols = static_cast<int>(game.GetState()[0].size());
+        auto Fail = [&](int64_t step, const char* what) {
+            cout << "level " << game.GetCurLevel() << " step " << step << " (seed " << seed << "): " << what << endl;
+            return 1;
+        };
+        const int64_t levelSteps = min(steps, max<int64_t>(MAX_TILES / (rows * cols), 1000));
+        for (int64_t step = 0; step < levelSteps; step++) {
+            auto r       = rng() % 100;
+            auto before  = BoardHash(game, false);
+            auto boxes   = BoardHash(game, true);
+            auto player  = game.GetPlayerPos();
+            auto pushes  = game.GetNumPushes();
+            if (r < 70) {
+                static constexpr int dy[] = {0, -1, 0, 1};
+                static constexpr int dx[] = {-1, 0, 1, 0};
+                auto d = rng() % 4;
+                game.Push(dy[d], dx[d]);
+                if (game.GetNumPushes() == pushes) {
+                    if (BoardHash(game, true) != boxes)
+                        return Fail(step, "a move without a push moved a box");
+                } else if (rng() % 2) {
+                    game.Regret();
+                    if (BoardHash(game, false) != before || !(game.GetPlayerPos() == player))
+                        return Fail(step, "push + regret didn't restore the board");
+                    game.Push(dy[d], dx[d]);
+                }
+            } else if (r < 85) {
+                game.Regret();
+                if (pushes && game.GetNumPushes() != pushes - 1)
+                    return Fail(step, "regret didn't undo a push");
+            } else if (r < 99) {
+                // a bit off the board, too.
+                game.Click({static_cast<int>(rng() % (rows + 2)) - 1, static_cast<int>(rng() % (cols + 2)) - 1});
+                if (game.GetNumPushes() == pushes && BoardHash(game, true) != boxes)
+                    return Fail(step, "a click without a push moved a box");
+            } else {
+                game.Restart();
+            }
+            if (!game.CheckInvariants())
+                return Fail(step, "invariants broken");
+        }
+        total += levelSteps;
+        if (game.IsLastLevel())
+            break;
+        game.NextLevel();
+    }
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    cout << total << " steps, " << static_cast<int64_t>(total / max(elapsed.count(), 1e-9)) << " steps/s" << endl;
+    return 0;
+}
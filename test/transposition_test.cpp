@@ -0,0 +1,63 @@
+// TranspositionTable replacement, on a table small enough to fill one probe
+// window by hand:
+//
+//   - positions whose hashes share a window all get a slot of their own,
+//   - a full window evicts the entry of the oldest bound, and among those
+//     the one of the largest g, and only that one.
+//
+// usage: transposition_test
+#include "game_transposition.hpp"
+
+#include <iostream>
+#include <cstdint>
+
+using namespace std;
+
+struct Entry {
+    const char* name;
+    uint64_t    hash;
+    uint64_t    boxes;
+    int32_t     g;
+    int32_t     bound;
+};
+
+int main() {
+    // one bitset word, 8 slots: every hash below is 0 mod 8, so all start probing at slot 0.
+    TranspositionTable table(8 * 5 * sizeof(uint64_t), 64);
+    if (table.NumSlots() != 8) {
+        cout << "expected 8 slots, got " << table.NumSlots() << endl;
+        return 1;
+    }
+    const Entry window[] = {
+        {"a",  8, 0x1, 0, 5},
+        {"b", 16, 0x2, 1, 3},
+        {"c", 24, 0x4, 2, 3},  // oldest bound, largest g: the victim.
+        {"d", 32, 0x8, 9, 5},
+    };
+    const Entry newcomer = {"e", 40, 0x10, 0, 6};
+
+    auto Visit = [&table](const Entry& e) { return table.Visit(e.hash, &e.boxes, 0, e.g, e.bound); };
+    auto Fail  = [](const char* what, const char* name) {
+        cout << what << ": " << name << endl;
+        return 1;
+    };
+    for (auto& e : window)
+        if (Visit(e) != TranspositionTable::VISIT_NEW)
+            return Fail("first visit not new", e.name);
+    for (auto& e : window)
+        if (Visit(e) != TranspositionTable::VISIT_SAME)
+            return Fail("lost from a window with room", e.name);
+
+    if (Visit(newcomer) != TranspositionTable::VISIT_NEW)
+        return Fail("first visit not new", newcomer.name);
+    for (auto& e : window)
+        if (&e != &window[2] && Visit(e) != TranspositionTable::VISIT_SAME)
+            return Fail("evicted instead of c", e.name);
+    if (Visit(newcomer) != TranspositionTable::VISIT_SAME)
+        return Fail("lost right after going in", newcomer.name);
+    if (Visit(window[2]) != TranspositionTable::VISIT_NEW)
+        return Fail("not evicted", window[2].name);
+
+    cout << "replacement ok" << endl;
+    return 0;
+}
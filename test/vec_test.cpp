@@ -0,0 +1,141 @@
+// VecSokoban against Sokoban: random actions in every game, each one
+// mirrored by a Sokoban on the same level, checking after every step that
+//
+//   - the board tensor shows the mirror's board (player facing aside),
+//   - an episode is reported done when the mirror solved the level, and
+//     only then with the solved reward,
+//
+// then the raw throughput of a larger batch.
+//
+// usage: vec_test [level file] [steps] [threads]
+#include "game.hpp"
+#include "game_vec.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+
+using namespace std;
+
+static constexpr int DY[VecSokoban::NUM_ACTIONS] = {0, -1, 0, 1};
+static constexpr int DX[VecSokoban::NUM_ACTIONS] = {-1, 0, 1, 0};
+
+// Rows [first, last) of the board, all of them by default.
+// The rows holding more than the void outside the walls: a step changes no others.
+static pair<size_t, size_t> LiveRows(const Sokoban& game) {
+    const auto& state = game.GetState();
+    auto Live = [](const vector<TileType>& row) {
+        return any_of(row.begin(), row.end(), [](TileType t) { return t != TILE_NULL; });
+    };
+    size_t first = 0, last = state.size();
+    while (first < last && !Live(state[first]))
+        first++;
+    while (last > first && !Live(state[last - 1]))
+        last--;
+    return {first, last};
+}
+
+static bool SameBoard(const Sokoban& game, const uint8_t* board, int32_t cols, size_t first = 0, size_t last = SIZE_MAX) {
+    const auto& state = game.GetState();
+    for (size_t r = first; r < min(last, state.size()); r++)
+        for (size_t c = 0; c < state[r].size(); c++) {
+            auto tile = (state[r][c] & TILE_PLAYER) ? state[r][c] & ~3 : state[r][c];
+            if (board[r * cols + c] != tile)
+                return false;
+        }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int64_t steps      = argc > 2 ? atoll(argv[2]) : 20'000;
+    int     numThreads = argc > 3 ? atoi(argv[3]) : 0;
+
+    Sokoban game;
+    game.LoadDefaultLevels();
+    if (argc > 1 && argv[1][0] && !game.LoadLevels(argv[1])) {
+        cout << "cannot load " << argv[1] << endl;
+        return 1;
+    }
+
+    VecSokoban::Options options;
+    options.numEnvs    = 2048;
+    options.numThreads = numThreads;
+    options.maxSteps   = 100;
+    vector<uint8_t> observations(VecSokoban::ObservationBytes(game, options));
+    VecSokoban vec(game, options, observations.data());
+    const auto cells = static_cast<size_t>(vec.Rows()) * vec.Cols();
+    if (vec.Observations() != observations.data() || observations.size() != static_cast<size_t>(vec.NumEnvs()) * cells)
+        return 1;
+
+    // each level loaded (and analyzed) once, copied into the mirrors on every reset.
+    vector<Sokoban>              fresh(game.GetNumLevels());
+    vector<pair<size_t, size_t>> liveRows(game.GetNumLevels());
+    for (int32_t level = 0; level < game.GetNumLevels(); level++) {
+        fresh[level].LoadLevel(game.GetLevel(level));
+        liveRows[level] = LiveRows(fresh[level]);
+    }
+    vector<Sokoban> mirrors(vec.NumEnvs());
+    for (int32_t env = 0; env < vec.NumEnvs(); env++)
+        mirrors[env] = fresh[vec.GetLevel(env)];
+
+    mt19937_64     rng(1);
+    vector<uint8_t> actions(vec.NumEnvs()), dones(vec.NumEnvs());
+    vector<float>   rewards(vec.NumEnvs());
+    int64_t episodes = 0, solved = 0;
+    for (int64_t step = 0; step < steps; step++) {
+        // mostly pushes toward where the last one went, so that some levels get solved.
+        for (auto& a : actions)
+            a = rng() % 3 ? a : rng() % VecSokoban::NUM_ACTIONS;
+        vec.Step(actions.data(), rewards.data(), dones.data());
+        for (int32_t env = 0; env < vec.NumEnvs(); env++) {
+            auto& mirror = mirrors[env];
+            mirror.Push(DY[actions[env]], DX[actions[env]]);
+            bool rewardSolved = rewards[env] > VecSokoban::REWARD_SOLVED / 2;
+            if (rewardSolved != mirror.LevelCompleted() || (mirror.LevelCompleted() && !dones[env])) {
+                cout << "step " << step << " env " << env << ": solved " << mirror.LevelCompleted()
+                     << ", reward " << rewards[env] << ", done " << int {dones[env]} << endl;
+                return 1;
+            }
+            // the whole board once an episode, the rows that can change every step.
+            auto rows = liveRows[vec.GetLevel(env)];
+            if (dones[env]) {
+                episodes++;
+                solved += rewardSolved;
+                mirror = fresh[vec.GetLevel(env)];
+                rows   = {0, SIZE_MAX};
+            }
+            if (!SameBoard(mirror, vec.Observations() + env * cells, vec.Cols(), rows.first, rows.second)) {
+                cout << "step " << step << " env " << env << ": boards differ" << endl;
+                return 1;
+            }
+        }
+    }
+    for (int32_t env = 0; env < vec.NumEnvs(); env++) {
+        if (!SameBoard(mirrors[env], vec.Observations() + env * cells, vec.Cols())) {
+            cout << "env " << env << ": boards differ at the end" << endl;
+            return 1;
+        }
+    }
+    cout << steps * vec.NumEnvs() << " steps checked, " << episodes << " episodes, " << solved << " solved" << endl;
+
+    // throughput, without the mirrors.
+    options.numEnvs = 16384;
+    VecSokoban big(game, options);
+    vector<vector<uint8_t>> actionSets(16, vector<uint8_t>(big.NumEnvs()));
+    for (auto& set : actionSets)
+        for (auto& a : set)
+            a = rng() % VecSokoban::NUM_ACTIONS;
+    rewards.resize(big.NumEnvs());
+    dones.resize(big.NumEnvs());
+    const int64_t batches = 400;
+    auto start = chrono::steady_clock::now();
+    for (int64_t b = 0; b < batches; b++)
+        big.Step(actionSets[b % actionSets.size()].data(), rewards.data(), dones.data());
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    cout << static_cast<int64_t>(batches * big.NumEnvs() / max(elapsed.count(), 1e-9)) << " steps/s" << endl;
+    return 0;
+}